@@ -0,0 +1,118 @@
+#
+# UPX "CMake" build file; see https://cmake.org/
+# Copyright (C) Markus Franz Xaver Johannes Oberhumer
+#
+
+#***********************************************************************
+# test "upx -d --extract-range" against a complete unpack
+#
+# usage:
+#   cmake -DUPX=upx [-DEMU=emulator] -DPACKED=file -DUNPACKED=file -P extract_range_test.cmake
+#
+# Checks that a range inside the first PT_LOAD matches the same bytes
+# of UNPACKED, and that a range in .bss or outside of every PT_LOAD is
+# rejected. Only 64-bit little-endian ELF is supported by --extract-range;
+# other files are skipped.
+#***********************************************************************
+
+if(NOT DEFINED UPX OR NOT DEFINED PACKED OR NOT DEFINED UNPACKED)
+    message(FATAL_ERROR "please set UPX, PACKED and UNPACKED")
+endif()
+
+# read an unsigned little-endian number of SIZE bytes at OFFSET
+function(read_le var file offset size)
+    file(READ "${file}" hex OFFSET ${offset} LIMIT ${size} HEX)
+    set(v 0)
+    math(EXPR i "${size} - 1")
+    while(NOT i LESS 0)
+        math(EXPR pos "2 * ${i}")
+        string(SUBSTRING "${hex}" ${pos} 2 byte)
+        foreach(n 0 1)
+            string(SUBSTRING "${byte}" ${n} 1 c)
+            string(FIND "0123456789abcdef" "${c}" d)
+            math(EXPR v "${v} * 16 + ${d}")
+        endforeach()
+        math(EXPR i "${i} - 1")
+    endwhile()
+    set(${var} ${v} PARENT_SCOPE)
+endfunction()
+
+function(extract_range result addr len out)
+    execute_process(COMMAND ${EMU} ${UPX} -q -d --extract-range=${addr}:${len} "${PACKED}"
+                            --force-overwrite -o "${out}"
+                    RESULT_VARIABLE rc OUTPUT_QUIET ERROR_QUIET)
+    set(${result} ${rc} PARENT_SCOPE)
+endfunction()
+
+file(READ "${UNPACKED}" ident LIMIT 6 HEX)
+if(NOT ident STREQUAL "7f454c460201")
+    message(STATUS "${UNPACKED}: not a 64-bit little-endian ELF; skipped")
+    return()
+endif()
+
+read_le(phoff "${UNPACKED}" 32 8)
+read_le(phentsize "${UNPACKED}" 54 2)
+read_le(phnum "${UNPACKED}" 56 2)
+set(text_vaddr "")
+set(bss_vaddr "")
+set(j 0)
+while(j LESS phnum)
+    math(EXPR p "${phoff} + ${j} * ${phentsize}")
+    read_le(p_type "${UNPACKED}" ${p} 4)
+    if(p_type EQUAL 1) # PT_LOAD
+        math(EXPR q "${p} + 8")
+        read_le(p_offset "${UNPACKED}" ${q} 8)
+        math(EXPR q "${p} + 16")
+        read_le(p_vaddr "${UNPACKED}" ${q} 8)
+        math(EXPR q "${p} + 32")
+        read_le(p_filesz "${UNPACKED}" ${q} 8)
+        math(EXPR q "${p} + 40")
+        read_le(p_memsz "${UNPACKED}" ${q} 8)
+        if(p_offset EQUAL 0 AND text_vaddr STREQUAL "")
+            set(text_vaddr ${p_vaddr})
+            set(text_filesz ${p_filesz})
+        endif()
+        if(p_filesz LESS p_memsz AND bss_vaddr STREQUAL "")
+            math(EXPR bss_vaddr "${p_vaddr} + ${p_filesz}")
+        endif()
+    endif()
+    math(EXPR j "${j} + 1")
+endwhile()
+if(text_vaddr STREQUAL "")
+    message(FATAL_ERROR "${UNPACKED}: no PT_LOAD at file offset 0")
+endif()
+
+# a range inside the first PT_LOAD, skipping the Elf64_Ehdr
+set(off 64)
+math(EXPR len "${text_filesz} - ${off}")
+if(len GREATER 1048576)
+    set(len 1048576)
+endif()
+math(EXPR addr "${text_vaddr} + ${off}")
+extract_range(rc ${addr} ${len} extract-range.out)
+if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "--extract-range=${addr}:${len} failed: ${rc}")
+endif()
+file(READ extract-range.out got HEX)
+file(READ "${UNPACKED}" expected OFFSET ${off} LIMIT ${len} HEX)
+if(NOT got STREQUAL expected)
+    message(FATAL_ERROR "--extract-range=${addr}:${len}: output differs from ${UNPACKED}")
+endif()
+
+# .bss is not in the file
+if(NOT bss_vaddr STREQUAL "")
+    extract_range(rc ${bss_vaddr} 16 extract-range.out)
+    if(rc EQUAL 0)
+        message(FATAL_ERROR "--extract-range=${bss_vaddr}:16 (.bss) did not fail")
+    endif()
+endif()
+
+# far beyond every PT_LOAD
+extract_range(rc 0x7fff00000000 16 extract-range.out)
+if(rc EQUAL 0)
+    message(FATAL_ERROR "--extract-range=0x7fff00000000:16 did not fail")
+endif()
+
+file(REMOVE extract-range.out)
+
+# vim:set ft=cmake ts=4 sw=4 tw=0 et:
@@ -0,0 +1,105 @@
+#
+# UPX "CMake" build file; see https://cmake.org/
+# Copyright (C) Markus Franz Xaver Johannes Oberhumer
+#
+
+#***********************************************************************
+# test the section table written by "upx --preserve-symbols"
+#
+# usage:
+#   cmake -DORIGINAL=file -DPACKED=file -P preserve_symbols_test.cmake
+#
+# Checks that PACKED has the same number of sections as ORIGINAL, that
+# every section keeps its sh_name and sh_addr, and that .symtab and its
+# .strtab keep their bytes. Only 64-bit little-endian ELF is supported by
+# --preserve-symbols; other files, and files without .symtab, are skipped.
+#***********************************************************************
+
+if(NOT DEFINED ORIGINAL OR NOT DEFINED PACKED)
+    message(FATAL_ERROR "please set ORIGINAL and PACKED")
+endif()
+
+# read an unsigned little-endian number of SIZE bytes at OFFSET
+function(read_le var file offset size)
+    file(READ "${file}" hex OFFSET ${offset} LIMIT ${size} HEX)
+    set(v 0)
+    math(EXPR i "${size} - 1")
+    while(NOT i LESS 0)
+        math(EXPR pos "2 * ${i}")
+        string(SUBSTRING "${hex}" ${pos} 2 byte)
+        foreach(n 0 1)
+            string(SUBSTRING "${byte}" ${n} 1 c)
+            string(FIND "0123456789abcdef" "${c}" d)
+            math(EXPR v "${v} * 16 + ${d}")
+        endforeach()
+        math(EXPR i "${i} - 1")
+    endwhile()
+    set(${var} ${v} PARENT_SCOPE)
+endfunction()
+
+# read field FIELD_OFFSET (of SIZE bytes) of Elf64_Shdr number J
+function(read_shdr var file j field_offset size)
+    read_le(shoff "${file}" 40 8)
+    math(EXPR p "${shoff} + ${j} * 64 + ${field_offset}")
+    read_le(v "${file}" ${p} ${size})
+    set(${var} ${v} PARENT_SCOPE)
+endfunction()
+
+# the bytes of section J, as hex
+function(read_section var file j)
+    read_shdr(sh_offset "${file}" ${j} 24 8)
+    read_shdr(sh_size "${file}" ${j} 32 8)
+    file(READ "${file}" v OFFSET ${sh_offset} LIMIT ${sh_size} HEX)
+    set(${var} "${v}" PARENT_SCOPE)
+endfunction()
+
+file(READ "${ORIGINAL}" ident LIMIT 6 HEX)
+if(NOT ident STREQUAL "7f454c460201")
+    message(STATUS "${ORIGINAL}: not a 64-bit little-endian ELF; skipped")
+    return()
+endif()
+
+read_le(shnum "${ORIGINAL}" 60 2)
+read_le(shnum_packed "${PACKED}" 60 2)
+if(NOT shnum_packed EQUAL shnum)
+    message(FATAL_ERROR "${PACKED}: e_shnum is ${shnum_packed}, expected ${shnum}")
+endif()
+
+set(symtab "")
+set(j 1)
+while(j LESS shnum)
+    foreach(field "0;4;sh_name" "16;8;sh_addr")
+        list(GET field 0 off)
+        list(GET field 1 size)
+        list(GET field 2 what)
+        read_shdr(expected "${ORIGINAL}" ${j} ${off} ${size})
+        read_shdr(got "${PACKED}" ${j} ${off} ${size})
+        if(NOT got EQUAL expected)
+            message(FATAL_ERROR "${PACKED}: section ${j}: ${what} is ${got}, expected ${expected}")
+        endif()
+    endforeach()
+    read_shdr(sh_type "${ORIGINAL}" ${j} 4 4)
+    if(sh_type EQUAL 2 AND symtab STREQUAL "") # SHT_SYMTAB
+        set(symtab ${j})
+    endif()
+    math(EXPR j "${j} + 1")
+endwhile()
+if(symtab STREQUAL "")
+    message(STATUS "${ORIGINAL}: no .symtab; contents not checked")
+    return()
+endif()
+
+read_shdr(strtab "${ORIGINAL}" ${symtab} 40 4) # sh_link
+foreach(j ${symtab} ${strtab})
+    read_shdr(sh_type "${PACKED}" ${j} 4 4)
+    if(sh_type EQUAL 8) # SHT_NOBITS
+        message(FATAL_ERROR "${PACKED}: section ${j} was not kept")
+    endif()
+    read_section(expected "${ORIGINAL}" ${j})
+    read_section(got "${PACKED}" ${j})
+    if(NOT got STREQUAL expected)
+        message(FATAL_ERROR "${PACKED}: section ${j} differs from ${ORIGINAL}")
+    endif()
+endforeach()
+
+# vim:set ft=cmake ts=4 sw=4 tw=0 et:
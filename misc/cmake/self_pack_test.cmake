@@ -46,6 +46,40 @@ upx_add_test(upx-unpack-nrv2d       upx -d upx-packed-nrv2d${exe} ${fo} -o upx-u
 upx_add_test(upx-unpack-nrv2e       upx -d upx-packed-nrv2e${exe} ${fo} -o upx-unpacked-nrv2e${exe})
 upx_add_test(upx-unpack-lzma        upx -d upx-packed-lzma${exe}  ${fo} -o upx-unpacked-lzma${exe})
 
+# --base: re-pack, re-using the blocks of upx-packed
+upx_add_test(upx-self-pack-base     upx -i -1 --base=upx-packed${exe} "${upx_self_exe}" ${fo} -o upx-packed-base${exe})
+# a different level only yields the same blocks if they were copied from the base
+set_tests_properties(upx-self-pack-base PROPERTIES PASS_REGULAR_EXPRESSION "--base: [1-9][0-9]* of [0-9]+ blocks re-used")
+upx_add_test(upx-unpack-base        upx -d upx-packed-base${exe}  ${fo} -o upx-unpacked-base${exe})
+
+# --extract-range: compare with upx-unpacked; .bss and out-of-file must fail
+string(REPLACE ";" "$<SEMICOLON>" emu_arg "${emu}")
+upx_add_test(upx-extract-range      "${CMAKE_COMMAND}" "-DEMU=${emu_arg}" "-DUPX=${upx_self_exe}"
+                                    -DPACKED=upx-packed${exe} -DUNPACKED=upx-unpacked${exe}
+                                    -P "${CMAKE_CURRENT_SOURCE_DIR}/misc/cmake/extract_range_test.cmake")
+
+# --estimate writes nothing; a directory walk quietly skips non-executables
+upx_add_test(upx-estimate           upx --estimate "${upx_self_exe}")
+if(NOT MSVC) # needs <dirent.h>
+    upx_add_test(upx-estimate-dir   upx --estimate "${CMAKE_CURRENT_SOURCE_DIR}/misc")
+endif()
+
+# --preserve-symbols: 64-bit ELF only; the section table must survive packing
+if(CMAKE_SYSTEM_NAME MATCHES "Linux" AND CMAKE_SIZEOF_VOID_P EQUAL 8)
+    upx_add_test(upx-self-pack-syms upx -3 --preserve-symbols "${upx_self_exe}" ${fo} -o upx-packed-syms${exe})
+    upx_add_test(upx-unpack-syms    upx -d upx-packed-syms${exe} ${fo} -o upx-unpacked-syms${exe})
+    upx_add_test(upx-compare-syms   "${CMAKE_COMMAND}" -E compare_files upx-unpacked${exe} upx-unpacked-syms${exe})
+    upx_add_test(upx-shdrs-syms     "${CMAKE_COMMAND}" "-DORIGINAL=${upx_self_exe}" -DPACKED=upx-packed-syms${exe}
+                                    -P "${CMAKE_CURRENT_SOURCE_DIR}/misc/cmake/preserve_symbols_test.cmake")
+    upx_test_depends(upx-unpack-syms  upx-self-pack-syms)
+    upx_test_depends(upx-compare-syms "upx-unpack;upx-unpack-syms")
+    upx_test_depends(upx-shdrs-syms   upx-self-pack-syms)
+    if(NOT UPX_CONFIG_DISABLE_RUN_PACKED_TEST)
+        upx_add_test(upx-run-packed-syms ${emu} ./upx-packed-syms${exe} --version-short)
+        upx_test_depends(upx-run-packed-syms upx-self-pack-syms)
+    endif()
+endif()
+
 # all unpacked files must be identical
 upx_add_test(upx-compare-fa         "${CMAKE_COMMAND}" -E compare_files upx-unpacked${exe} upx-unpacked-fa${exe})
 upx_add_test(upx-compare-fn         "${CMAKE_COMMAND}" -E compare_files upx-unpacked${exe} upx-unpacked-fn${exe})
@@ -54,6 +88,7 @@ upx_add_test(upx-compare-nrv2b      "${CMAKE_COMMAND}" -E compare_files upx-unpa
 upx_add_test(upx-compare-nrv2d      "${CMAKE_COMMAND}" -E compare_files upx-unpacked${exe} upx-unpacked-nrv2d${exe})
 upx_add_test(upx-compare-nrv2e      "${CMAKE_COMMAND}" -E compare_files upx-unpacked${exe} upx-unpacked-nrv2e${exe})
 upx_add_test(upx-compare-lzma       "${CMAKE_COMMAND}" -E compare_files upx-unpacked${exe} upx-unpacked-lzma${exe})
+upx_add_test(upx-compare-base       "${CMAKE_COMMAND}" -E compare_files upx-unpacked${exe} upx-unpacked-base${exe})
 
 # test dependencies
 upx_test_depends(upx-list           "upx-self-pack;upx-self-pack-fa;upx-self-pack-fn;upx-self-pack-fr;upx-self-pack-nrv2b;upx-self-pack-nrv2d;upx-self-pack-nrv2e;upx-self-pack-lzma")
@@ -67,6 +102,9 @@ upx_test_depends(upx-unpack-nrv2b   upx-self-pack-nrv2b)
 upx_test_depends(upx-unpack-nrv2d   upx-self-pack-nrv2d)
 upx_test_depends(upx-unpack-nrv2e   upx-self-pack-nrv2e)
 upx_test_depends(upx-unpack-lzma    upx-self-pack-lzma)
+upx_test_depends(upx-self-pack-base upx-self-pack)
+upx_test_depends(upx-unpack-base    upx-self-pack-base)
+upx_test_depends(upx-extract-range  upx-unpack)
 upx_test_depends(upx-compare-fa     "upx-unpack;upx-unpack-fa")
 upx_test_depends(upx-compare-fn     "upx-unpack;upx-unpack-fn")
 upx_test_depends(upx-compare-fr     "upx-unpack;upx-unpack-fr")
@@ -74,6 +112,7 @@ upx_test_depends(upx-compare-nrv2b  "upx-unpack;upx-unpack-nrv2b")
 upx_test_depends(upx-compare-nrv2d  "upx-unpack;upx-unpack-nrv2d")
 upx_test_depends(upx-compare-nrv2e  "upx-unpack;upx-unpack-nrv2e")
 upx_test_depends(upx-compare-lzma   "upx-unpack;upx-unpack-lzma")
+upx_test_depends(upx-compare-base   "upx-unpack;upx-unpack-base")
 # tests with higher COST values will run first
 set_tests_properties(upx-self-pack       PROPERTIES COST 90)
 set_tests_properties(upx-self-pack-fa    PROPERTIES COST 20)
@@ -99,6 +138,7 @@ if(NOT UPX_CONFIG_DISABLE_RUN_PACKED_TEST)
     upx_add_test(upx-run-packed-nrv2d       ${emu} ./upx-packed-nrv2d${exe} --version-short)
     upx_add_test(upx-run-packed-nrv2e       ${emu} ./upx-packed-nrv2e${exe} --version-short)
     upx_add_test(upx-run-packed-lzma        ${emu} ./upx-packed-lzma${exe}  --version-short)
+    upx_add_test(upx-run-packed-base        ${emu} ./upx-packed-base${exe}  --version-short)
     upx_test_depends(upx-run-packed         upx-self-pack)
     upx_test_depends(upx-run-packed-fa      upx-self-pack-fa)
     upx_test_depends(upx-run-packed-fn      upx-self-pack-fn)
@@ -107,6 +147,7 @@ if(NOT UPX_CONFIG_DISABLE_RUN_PACKED_TEST)
     upx_test_depends(upx-run-packed-nrv2d   upx-self-pack-nrv2d)
     upx_test_depends(upx-run-packed-nrv2e   upx-self-pack-nrv2e)
     upx_test_depends(upx-run-packed-lzma    upx-self-pack-lzma)
+    upx_test_depends(upx-run-packed-base    upx-self-pack-base)
 endif()
 
 #
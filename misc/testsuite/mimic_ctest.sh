@@ -139,6 +139,37 @@ fo="--force-overwrite"
 "${run_upx[@]}" -d upx-packed-nrv2e${exe} ${fo} -o upx-unpacked-nrv2e${exe}
 "${run_upx[@]}" -d upx-packed-lzma${exe}  ${fo} -o upx-unpacked-lzma${exe}
 
+# --base: re-pack, re-using the blocks of upx-packed
+# (a different level only yields the same blocks if they were copied from the base)
+"${run_upx[@]}" -i -1 --base=upx-packed${exe} "${upx_self_exe}" ${fo} -o upx-packed-base${exe} \
+    | grep -E -e '--base: [1-9][0-9]* of [0-9]+ blocks re-used'
+"${run_upx[@]}" -d upx-packed-base${exe}  ${fo} -o upx-unpacked-base${exe}
+
+# --extract-range: compare with upx-unpacked; .bss and out-of-file must fail
+if command -v cmake >/dev/null; then
+    cmake "-DEMU=$(IFS=';'; echo "${emu[*]}")" "-DUPX=$upx_exe" \
+          -DPACKED=upx-packed${exe} -DUNPACKED=upx-unpacked${exe} \
+          -P "$argv0dir/../cmake/extract_range_test.cmake"
+fi
+
+# --estimate writes nothing; a directory walk quietly skips non-executables
+"${run_upx[@]}" --estimate "${upx_self_exe}"
+"${run_upx[@]}" --estimate "$argv0dir/.."
+
+# --preserve-symbols: 64-bit ELF only; the section table must survive packing
+if [[ $(od -An -tx1 -N5 "${upx_self_exe}" | tr -d ' \n') == 7f454c4602 ]]; then
+    "${run_upx[@]}" -3 --preserve-symbols "${upx_self_exe}" ${fo} -o upx-packed-syms${exe}
+    "${run_upx[@]}" -d upx-packed-syms${exe} ${fo} -o upx-unpacked-syms${exe}
+    cmp -s upx-unpacked${exe} upx-unpacked-syms${exe}
+    if command -v cmake >/dev/null; then
+        cmake "-DORIGINAL=${upx_self_exe}" -DPACKED=upx-packed-syms${exe} \
+              -P "$argv0dir/../cmake/preserve_symbols_test.cmake"
+    fi
+    if [[ $UPX_CONFIG_DISABLE_RUN_PACKED_TEST != ON ]]; then
+        "${emu[@]}" ./upx-packed-syms${exe} --version-short
+    fi
+fi
+
 # all unpacked files must be identical
 cmp -s upx-unpacked${exe} upx-unpacked-fa${exe}
 cmp -s upx-unpacked${exe} upx-unpacked-fn${exe}
@@ -147,6 +178,7 @@ cmp -s upx-unpacked${exe} upx-unpacked-nrv2b${exe}
 cmp -s upx-unpacked${exe} upx-unpacked-nrv2d${exe}
 cmp -s upx-unpacked${exe} upx-unpacked-nrv2e${exe}
 cmp -s upx-unpacked${exe} upx-unpacked-lzma${exe}
+cmp -s upx-unpacked${exe} upx-unpacked-base${exe}
 
 if [[ $UPX_CONFIG_DISABLE_RUN_UNPACKED_TEST != ON ]]; then
     "${emu[@]}" ./upx-unpacked${exe} --version-short
@@ -161,6 +193,7 @@ if [[ $UPX_CONFIG_DISABLE_RUN_PACKED_TEST != ON ]]; then
     "${emu[@]}" ./upx-packed-nrv2d${exe} --version-short
     "${emu[@]}" ./upx-packed-nrv2e${exe} --version-short
     "${emu[@]}" ./upx-packed-lzma${exe}  --version-short
+    "${emu[@]}" ./upx-packed-base${exe}  --version-short
 fi
 
 if [[ $UPX_CONFIG_DISABLE_EXHAUSTIVE_TESTS != ON ]]; then
@@ -1081,6 +1081,12 @@ int __acc_cdecl_qsort le32_compare_signed(const void *, const void *);
 int __acc_cdecl_qsort le64_compare_signed(const void *, const void *);
 } // extern "C"
 
+// bulk in-place byte swapping of n consecutive (possibly unaligned) elements;
+// uses SSSE3/AVX2/NEON shuffles when available
+void bswap16_array(void *array, size_t n) noexcept;
+void bswap32_array(void *array, size_t n) noexcept;
+void bswap64_array(void *array, size_t n) noexcept;
+
 // <type_traits> upx_is_integral; see conf.h
 #define TT_UPX_IS_INTEGRAL(T)                                                                      \
     template <>                                                                                    \
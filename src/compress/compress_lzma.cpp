@@ -44,6 +44,7 @@ void lzma_compress_config_t::reset() noexcept {
     fast_mode = 2;
     num_fast_bytes.reset();
     match_finder_cycles = 0;
+    match_finder.reset();
 
     max_num_probs = 0;
 }
@@ -72,6 +73,7 @@ static bool prepare_result(lzma_compress_result_t *res, unsigned src_len, int me
     res->fast_mode = 2;               // 0 .. 2
     res->num_fast_bytes = 64;         // 5 .. 273
     res->match_finder_cycles = 0;
+    res->match_finder = 3;            // BT4
     // UPX overrides
     res->pos_bits = lzma_compress_config_t::pos_bits_t::default_value;
     res->lit_pos_bits = lzma_compress_config_t::lit_pos_bits_t::default_value;
@@ -132,6 +134,8 @@ static bool prepare_result(lzma_compress_result_t *res, unsigned src_len, int me
         upx::oassign(res->lit_context_bits, lcconf->lit_context_bits);
         upx::oassign(res->dict_size, lcconf->dict_size);
         upx::oassign(res->num_fast_bytes, lcconf->num_fast_bytes);
+        if (lcconf->match_finder)
+            res->match_finder = lcconf->match_finder;
     }
 
     // limit dictionary size
@@ -161,6 +165,7 @@ static bool prepare_result(lzma_compress_result_t *res, unsigned src_len, int me
     lzma_compress_config_t::lit_context_bits_t::assertValue(res->lit_context_bits);
     lzma_compress_config_t::dict_size_t::assertValue(res->dict_size);
     lzma_compress_config_t::num_fast_bytes_t::assertValue(res->num_fast_bytes);
+    lzma_compress_config_t::match_finder_t::assertValue(res->match_finder);
 
     res->num_probs = 1846 + (768u << (res->lit_context_bits + res->lit_pos_bits));
     NO_printf("\nlzma_compress config: %u %u %u %u %u\n", res->pos_bits, res->lit_pos_bits,
@@ -288,6 +293,33 @@ STDMETHODIMP ProgressInfo::SetRatioInfo(const UInt64 *inSize, const UInt64 *outS
 #pragma GCC diagnostic pop
 #endif
 
+// Keep one encoder per thread: CEncoder::Create() re-uses the match finder
+// tables and the range coder buffer as long as the match finder, the
+// dictionary size and num_fast_bytes stay the same, which saves allocating
+// and clearing several MiB for every block and every trial.
+// Only encoders with a small dictionary are kept, so that an idle worker
+// thread pins at most about 16 MiB (BT4 tables for a 1 MiB dictionary).
+static constexpr unsigned LZMA_ENCODER_CACHE_MAX_DICT = 1024 * 1024;
+namespace {
+struct LzmaEncoderCache final {
+    NCompress::NLZMA::CEncoder *enc = nullptr;
+    ~LzmaEncoderCache() noexcept { discard(); }
+    NCompress::NLZMA::CEncoder &get() {
+        if (enc == nullptr) {
+            enc = new NCompress::NLZMA::CEncoder;
+            enc->AddRef();
+        }
+        return *enc;
+    }
+    void discard() noexcept {
+        if (enc != nullptr)
+            enc->Release();
+        enc = nullptr;
+    }
+};
+static upx_thread_local LzmaEncoderCache lzma_encoder_cache;
+} // namespace
+
 int upx_lzma_compress(const upx_bytep src, unsigned src_len, upx_bytep dst, unsigned *dst_len,
                       upx_callback_t *cb, int method, int level,
                       const upx_compress_config_t *cconf_parm, upx_compress_result_t *cresult) {
@@ -311,7 +343,7 @@ int upx_lzma_compress(const upx_bytep src, unsigned src_len, upx_bytep dst, unsi
     progress.AddRef();
     progress.cb = cb; // progress.Init()
 
-    NCompress::NLZMA::CEncoder enc;
+    NCompress::NLZMA::CEncoder &enc = lzma_encoder_cache.get();
     constexpr unsigned NPROPS = 8;
     static const PROPID propIDs[NPROPS] = {
         NCoderPropID::kPosStateBits,      // 0  pb    _posStateBits(2)
@@ -335,9 +367,9 @@ int upx_lzma_compress(const upx_bytep src, unsigned src_len, upx_bytep dst, unsi
     pr[4].uintVal = res->fast_mode;
     pr[5].uintVal = res->num_fast_bytes;
     pr[6].uintVal = res->match_finder_cycles;
-    static const wchar_t matchfinder[] = L"BT4";
-    assert(NCompress::NLZMA::FindMatchFinder(matchfinder) >= 0);
-    pr[7].bstrVal = ACC_PCAST(BSTR, ACC_UNCONST_CAST(wchar_t *, matchfinder));
+    static const wchar_t *const matchfinders[5] = {nullptr, L"BT2", L"BT3", L"BT4", L"HC4"};
+    assert(NCompress::NLZMA::FindMatchFinder(matchfinders[res->match_finder]) >= 0);
+    pr[7].bstrVal = ACC_PCAST(BSTR, ACC_UNCONST_CAST(wchar_t *, matchfinders[res->match_finder]));
 
     try {
         if (enc.SetCoderProperties(propIDs, pr, NPROPS) != S_OK)
@@ -380,6 +412,9 @@ int upx_lzma_compress(const upx_bytep src, unsigned src_len, upx_bytep dst, unsi
     }
 
 error:
+    // do not re-use an encoder in an unknown state, nor keep a large one
+    if (r != UPX_E_OK || res->dict_size > LZMA_ENCODER_CACHE_MAX_DICT)
+        lzma_encoder_cache.discard();
     *dst_len = (unsigned) os.b_pos;
     NO_printf("\nlzma_compress: %d: %u %u %u %u %u, %u - > %u\n", r, res->pos_bits,
               res->lit_pos_bits, res->lit_context_bits, res->dict_size, res->num_probs, src_len,
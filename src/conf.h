@@ -116,7 +116,7 @@ static_assert((char) (-1) == 255);             // -funsigned-char
 //   note that noexcept(false) is the default for all C++ functions anyway
 #define may_throw noexcept(false)
 
-// multithreading (UPX currently does not use multithreading)
+// multithreading; see util/work_sched.h
 #if (WITH_THREADS)
 #define upx_thread_local     thread_local
 #define upx_std_atomic(Type) std::atomic<Type>
@@ -676,6 +676,8 @@ struct lzma_compress_config_t final {
     typedef upx::OptVar<unsigned, 3u, 0u, 8u> lit_context_bits_t; // lc
     typedef upx::OptVar<unsigned, (1u << 22), 1u, (1u << 30)> dict_size_t;
     typedef upx::OptVar<unsigned, 64u, 5u, 273u> num_fast_bytes_t;
+    // 0: default (BT4), 1: BT2, 2: BT3, 3: BT4, 4: HC4
+    typedef upx::OptVar<unsigned, 0u, 0u, 4u> match_finder_t;
 
     pos_bits_t pos_bits;                 // pb
     lit_pos_bits_t lit_pos_bits;         // lp
@@ -684,6 +686,7 @@ struct lzma_compress_config_t final {
     unsigned fast_mode;
     num_fast_bytes_t num_fast_bytes;
     unsigned match_finder_cycles;
+    match_finder_t match_finder; // mf
 
     unsigned max_num_probs;
 
@@ -748,7 +751,8 @@ struct lzma_compress_result_t final {
     unsigned fast_mode;
     unsigned num_fast_bytes;
     unsigned match_finder_cycles;
-    unsigned num_probs; // (computed result)
+    unsigned match_finder; // see lzma_compress_config_t::match_finder_t
+    unsigned num_probs;    // (computed result)
 
     void reset() noexcept { mem_clear(this); }
 };
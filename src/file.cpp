@@ -27,6 +27,10 @@
 
 #include "conf.h"
 #include "file.h"
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
 
 /*************************************************************************
 // static file-related util functions; will throw on error
@@ -108,15 +112,19 @@ bool FileBase::do_sopen() {
 
 bool FileBase::close_noexcept() noexcept {
     bool ok = true;
-    if (isOpen() && _fd != STDIN_FILENO && _fd != STDOUT_FILENO && _fd != STDERR_FILENO)
+    if (isOpen() && _fd != STDIN_FILENO && _fd != STDOUT_FILENO && _fd != STDERR_FILENO) {
+        if (opt->no_cache_pollution)
+            adviseDontNeed();
         if (::close(_fd) == -1)
             ok = false;
+    }
     _fd = -1;
     _flags = 0;
     _mode = 0;
     _name = nullptr;
     _offset = 0;
     _length = 0;
+    _ntouched = 0;
     return ok;
 }
 
@@ -165,6 +173,113 @@ void FileBase::set_extent(upx_off_t offset, upx_off_t length) {
 
 upx_off_t FileBase::st_size() const { return _length; }
 
+// The packers read most of each file once, so the kernel may read ahead
+// sequentially, and --no-cache-pollution lets a batch run over many big
+// files leave the page cache to the data which the host actually reuses.
+// Only the ranges which upx itself read or wrote are dropped: pages of the
+// input which some other process keeps cached are left alone.
+void FileBase::adviseWillNeed(upx_off_t off, upx_off_t len) const noexcept {
+#if defined(POSIX_FADV_WILLNEED)
+    if (isOpen() && off >= 0 && len > 0)
+        (void) ::posix_fadvise(_fd, _offset + off, len, POSIX_FADV_WILLNEED);
+#else
+    UNUSED(off);
+    UNUSED(len);
+#endif
+}
+
+void FileBase::noteAccess(upx_off_t pos, upx_off_t len) noexcept {
+    if (pos < 0 || len <= 0)
+        return;
+    upx_off_t lo = pos, hi = pos + len;
+    // coalesce with every overlapping or adjacent extent
+    unsigned n = 0;
+    for (unsigned i = 0; i < _ntouched; i++) {
+        const Extent &x = _touched[i];
+        if (x.hi < lo || hi < x.lo)
+            _touched[n++] = x;
+        else {
+            lo = upx::min(lo, x.lo);
+            hi = upx::max(hi, x.hi);
+        }
+    }
+    if (n == MAX_TOUCHED) { // full: widen the nearest extent
+        unsigned best = 0;
+        upx_off_t best_gap = 0;
+        for (unsigned i = 0; i < n; i++) {
+            const Extent &x = _touched[i];
+            const upx_off_t gap = x.hi < lo ? lo - x.hi : x.lo - hi;
+            if (i == 0 || gap < best_gap) {
+                best = i;
+                best_gap = gap;
+            }
+        }
+        _touched[best].lo = upx::min(lo, _touched[best].lo);
+        _touched[best].hi = upx::max(hi, _touched[best].hi);
+    } else {
+        _touched[n].lo = lo;
+        _touched[n].hi = hi;
+        n++;
+    }
+    _ntouched = n;
+}
+
+#if defined(__linux__) && defined(__NR_cachestat)
+// cachestat(2), Linux 6.5; the structs of <linux/mman.h>
+namespace {
+struct CacheStatRange final {
+    upx_uint64_t off, len;
+};
+struct CacheStat final {
+    upx_uint64_t nr_cache, nr_dirty, nr_writeback, nr_evicted, nr_recently_evicted;
+};
+} // namespace
+
+// number of cached pages of the touched ranges, or -1 if unknown
+static upx_int64_t cached_pages(int fd, const CacheStatRange *r, unsigned n) noexcept {
+    upx_int64_t pages = 0;
+    for (unsigned i = 0; i < n; i++) {
+        CacheStat cs = {};
+        if (::syscall(__NR_cachestat, fd, &r[i], &cs, 0) != 0)
+            return -1;
+        pages += cs.nr_cache;
+    }
+    return pages;
+}
+#endif
+
+void FileBase::adviseDontNeed() noexcept {
+#if defined(POSIX_FADV_DONTNEED)
+    if (!isOpen() || _ntouched == 0)
+        return;
+    // whole pages, as the kernel only drops fully covered ones
+    static const upx_off_t page = upx::max(::sysconf(_SC_PAGESIZE), 4096L);
+#if defined(__linux__) && defined(__NR_cachestat)
+    CacheStatRange ranges[MAX_TOUCHED];
+    for (unsigned i = 0; i < _ntouched; i++) {
+        ranges[i].off = _touched[i].lo & ~(page - 1);
+        ranges[i].len = ((_touched[i].hi + page - 1) & ~(page - 1)) - ranges[i].off;
+    }
+    const upx_int64_t before = opt->verbose >= 3 ? cached_pages(_fd, ranges, _ntouched) : -1;
+#endif
+    // On Linux this also starts (but does not wait for) the write-back of
+    // dirty pages; pages still under write-back stay cached until the
+    // kernel reclaims them.
+    for (unsigned i = 0; i < _ntouched; i++) {
+        const upx_off_t lo = _touched[i].lo & ~(page - 1);
+        const upx_off_t hi = (_touched[i].hi + page - 1) & ~(page - 1);
+        (void) ::posix_fadvise(_fd, lo, hi - lo, POSIX_FADV_DONTNEED);
+    }
+#if defined(__linux__) && defined(__NR_cachestat)
+    if (before >= 0) {
+        const upx_int64_t after = cached_pages(_fd, ranges, _ntouched);
+        info("%s: page cache %lld -> %lld pages in %u range%s", _name, (long long) before,
+             (long long) after, _ntouched, _ntouched == 1 ? "" : "s");
+    }
+#endif
+#endif
+}
+
 /*************************************************************************
 // InputFile
 **************************************************************************/
@@ -186,16 +301,21 @@ void InputFile::sopen(const char *name, int flags, int shflags) {
             throwIOException(_name, errno);
     }
     _length_orig = _length;
+#if defined(POSIX_FADV_SEQUENTIAL)
+    (void) ::posix_fadvise(_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
 }
 
 int InputFile::read(SPAN_P(void) buf, upx_int64_t blen) {
     if (!isOpen() || blen < 0)
         throwIOException("bad read");
     int len = (int) mem_size(1, blen); // sanity check
+    const upx_off_t pos = opt->no_cache_pollution ? ::lseek(_fd, 0, SEEK_CUR) : -1;
     errno = 0;
     long l = acc_safe_hread(_fd, raw_bytes(buf, len), len);
     if (errno)
         throwIOException("read error", errno);
+    noteAccess(pos, l);
     return (int) l;
 }
 
@@ -284,9 +404,11 @@ void OutputFile::write(SPAN_0(const void) buf, upx_int64_t blen) {
     NO_fprintf(stderr, "write %p %zd (%p) %d\n", buf.raw_ptr(), buf.raw_size_in_bytes(),
                buf.raw_base(), len);
 #endif
+    const upx_off_t pos = opt->no_cache_pollution ? ::lseek(_fd, 0, SEEK_CUR) : -1;
     long l = acc_safe_hwrite(_fd, raw_bytes(buf, len), len);
     if (l != len)
         throwIOException("write error", errno);
+    noteAccess(pos, len);
     bytes_written += len;
 #if TESTING && 0
     static upx_std_atomic(bool) dumping;
@@ -301,6 +423,48 @@ void OutputFile::write(SPAN_0(const void) buf, upx_int64_t blen) {
 #endif
 }
 
+// Copy len bytes from the current position of fi to the current position
+// of this file inside the kernel, without a round-trip through user space.
+// copy_file_range() may even share the blocks (reflink) on filesystems
+// which support it. Returns the number of bytes copied, which is less than
+// len (possibly 0) if the kernel cannot do it; the caller then continues
+// with read() + write() from the updated positions.
+upx_int64_t OutputFile::copyFrom(InputFile *fi, upx_int64_t len) {
+    if (!isOpen() || !fi || !fi->isOpen() || len < 0)
+        throwIOException("bad copy");
+    upx_int64_t done = 0;
+#if defined(__linux__)
+    const int in_fd = fi->getFd();
+    const upx_off_t in_pos = opt->no_cache_pollution ? ::lseek(in_fd, 0, SEEK_CUR) : -1;
+    const upx_off_t out_pos = opt->no_cache_pollution ? ::lseek(_fd, 0, SEEK_CUR) : -1;
+    bool use_cfr = !opt->to_stdout; // copy_file_range() needs regular files
+    while (done < len) {
+        size_t const n = (size_t) UPX_MIN(len - done, (upx_int64_t) 0x40000000); // 1 GiB
+        ssize_t l = -1;
+#if defined(__GLIBC__) && (__GLIBC__ * 100 + __GLIBC_MINOR__ >= 227)
+        if (use_cfr) {
+            l = ::copy_file_range(in_fd, nullptr, _fd, nullptr, n, 0);
+            if (l < 0) {
+                use_cfr = false; // EXDEV, ENOSYS, EINVAL...: try sendfile()
+                continue;
+            }
+        } else
+#endif
+            l = ::sendfile(_fd, in_fd, nullptr, n);
+        UNUSED(use_cfr);
+        if (l <= 0)
+            break; // let the caller fall back to read() + write()
+        done += l;
+    }
+    fi->noteAccess(in_pos, done);
+    noteAccess(out_pos, done);
+    bytes_written += done;
+#else
+    UNUSED(fi);
+#endif
+    return done;
+}
+
 upx_off_t OutputFile::st_size() const {
     if (opt->to_stdout) {     // might be a pipe ==> .st_size is invalid
         return bytes_written; // too big if seek()+write() instead of rewrite()
@@ -389,6 +553,7 @@ TEST_CASE("file") {
     CHECK(!fo.isOpen());
     CHECK(fo.getFd() == -1);
     CHECK(fo.getBytesWritten() == 0);
+    CHECK_THROWS(fo.copyFrom(&fi, 0));
 }
 
 /* vim:set ts=4 sw=4 et: */
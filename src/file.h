@@ -48,6 +48,11 @@ public:
     virtual upx_off_t st_size() const; // { return _length; }
     virtual void set_extent(upx_off_t offset, upx_off_t length);
 
+    // page cache hints; these never fail
+    void adviseWillNeed(upx_off_t off, upx_off_t len) const noexcept;
+    void adviseDontNeed() noexcept; // drop the cached pages of the ranges we touched
+    void noteAccess(upx_off_t pos, upx_off_t len) noexcept; // pos: absolute file offset
+
 public:
     // static file-related util functions; will throw on error
     static void chmod(const char *name, int mode) may_throw;
@@ -64,6 +69,13 @@ protected:
     const char *_name = nullptr;
     upx_off_t _offset = 0;
     upx_off_t _length = 0;
+    // the byte ranges read or written, for --no-cache-pollution
+    struct Extent {
+        upx_off_t lo, hi;
+    };
+    static constexpr unsigned MAX_TOUCHED = 8;
+    Extent _touched[MAX_TOUCHED] = {};
+    unsigned _ntouched = 0;
 
 public:
     struct stat st = {};
@@ -110,6 +122,8 @@ public:
 
     // info: allow nullptr if blen == 0
     void write(SPAN_0(const void) buf, upx_int64_t blen);
+    // kernel-side copy from fi; returns bytes copied, may be less than len
+    upx_int64_t copyFrom(InputFile *fi, upx_int64_t len);
 
     virtual upx_off_t seek(upx_off_t off, int whence) override;
     virtual upx_off_t st_size() const override; // { return _length; }
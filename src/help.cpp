@@ -253,6 +253,13 @@ void show_help(int verbose) {
                     "  --lzma              try LZMA [slower but tighter than NRV]\n"
                     "  --brute             try all available compression methods & filters [slow]\n"
                     "  --ultra-brute       try even more compression variants [very slow]\n"
+                    "  --time-budget=SEC   stop trying more variants after SEC seconds per file;\n"
+                    "                        variants are tried in the usual order\n"
+                    "  --optimize-for=size|balanced|startup  weigh in decompression speed\n"
+                    "  --threads=N         use at most N threads; 0 = number of CPUs [default: 1]\n"
+                    "                        [every method tried in parallel needs its own buffer]\n"
+                    "  --estimate          predict packed size and times from samples, write\n"
+                    "                        nothing; directories are searched recursively\n"
                     "\n");
         fg = con_fg(f, FG_YELLOW);
         con_fprintf(f, "Backup options:\n");
@@ -278,6 +285,7 @@ void show_help(int verbose) {
                     "  --link              preserve hard links (Unix only) [USE WITH CARE]\n"
                     "  --no-link           do not preserve hard links but rename files [default]\n"
 #endif
+                    "  --no-cache-pollution  drop what upx read or wrote from the page cache\n"
                     "  --no-mode           do not preserve file mode (aka permissions)\n"
                     "  --no-owner          do not preserve file ownership\n"
                     "  --no-time           do not preserve file timestamp\n"
@@ -342,7 +350,14 @@ void show_help(int verbose) {
         fg = con_fg(f, fg);
         con_fprintf(f,
                     "  --preserve-build-id     copy .gnu.note.build-id to compressed output\n"
+                    "  --preserve-symbols      also keep .symtab and section addresses (64-bit)\n"
+                    "  --extract-range=ADDR:LEN  only de-compress [ADDR,+LEN) of the program\n"
+                    "                            [output is not verified by checksum]\n"
                     "  --catch-sigsegv         debug errors in hardware or de-compressor\n"
+                    "  --base=FILE             re-use unchanged blocks of previously packed FILE\n"
+                    "                            [costs a full unpack of FILE on every run]\n"
+                    "  --cdc-blocks            content-defined block boundaries (for delta transfer)\n"
+                    "  --blocksize=auto        choose the block size of each PT_LOAD from its content\n"
                     "\n");
     }
     // clang-format on
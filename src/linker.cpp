@@ -366,6 +366,7 @@ ElfLinker::Relocation *ElfLinker::addRelocation(const char *section, unsigned of
     if (grow_capacity(nrelocations, &nrelocations_capacity))
         relocations = realloc_array(relocations, nrelocations_capacity);
     Relocation *rel = new Relocation(findSection(section), off, type, findSymbol(symbol), add);
+    decodeRelocation(rel);
     relocations[nrelocations++] = rel;
     return rel;
 }
@@ -497,7 +498,12 @@ void ElfLinker::relocate() {
         NO_printf("  %llx %d %llx %d %llx :%d\n", (long long) value,
                   (int) rel->value->section->offset, rel->value->offset, rel->offset,
                   (long long) rel->add, *location);
-        relocate1(rel, location, value, rel->type);
+        if (rel->pcrel)
+            value -= rel->section->offset + rel->offset;
+        if (rel->kind == RK_DATA)
+            relocateData(rel, location, value);
+        else if (rel->kind != RK_NONE)
+            relocate1(rel, location, value, rel->type);
     }
 }
 
@@ -561,6 +567,23 @@ void ElfLinker::alignWithByte(unsigned len, byte b) {
     outputlen += len;
 }
 
+void ElfLinker::relocateData(const Relocation *rel, byte *location, upx_uint64_t value) const {
+    if (rel->width == 8) {
+        int displ = (upx_int8_t) *location + (int) value;
+        if (rel->range_check && (displ < -128 || displ > 127))
+            throwInternalError("target out of range (%d) in reloc %s:%x\n", displ,
+                               rel->section->name, rel->offset);
+        *location += value;
+    } else if (rel->width == 16)
+        bele->set16(location, bele->get16(location) + value);
+    else if (rel->width == 32)
+        bele->set32(location, bele->get32(location) + value);
+    else if (rel->width == 64)
+        bele->set64(location, bele->get64(location) + value);
+    else
+        throwInternalError("bad relocation width %d for '%s'\n", rel->width, rel->type);
+}
+
 void ElfLinker::relocate1(const Relocation *rel, byte *, upx_uint64_t, const char *) {
     throwInternalError("unknown relocation type '%s\n'", rel->type);
 }
@@ -582,50 +605,52 @@ static void check8(const Relocation *rel, const byte *location, int v, int d) {
 }
 #endif
 
-void ElfLinkerAMD64::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
-                               const char *type) {
+void ElfLinkerAMD64::decodeRelocation(Relocation *rel) const {
+    const char *type = rel->type;
     if (strncmp(type, "R_X86_64_", 9))
-        return super::relocate1(rel, location, value, type);
+        return;
     type += 9;
 
-    bool range_check = false;
     if (strncmp(type, "PC", 2) == 0) {
         type += 2;
-        value -= rel->section->offset + rel->offset;
-        range_check = true;
+        rel->pcrel = rel->range_check = true;
     } else if (strncmp(type, "PLT", 3) == 0) {
         type += 3;
-        value -= rel->section->offset + rel->offset;
-        range_check = true;
+        rel->pcrel = rel->range_check = true;
     }
 
-    if (strcmp(type, "8") == 0) {
-        int displ = (upx_int8_t) *location + (int) value;
-        if (range_check && (displ < -128 || displ > 127))
-            throwInternalError("target out of range (%d) in reloc %s:%x\n", displ,
-                               rel->section->name, rel->offset);
-        *location += value;
-    } else if (strcmp(type, "16") == 0)
-        set_le16(location, get_le16(location) + value);
+    if (strcmp(type, "8") == 0)
+        rel->setData(8);
+    else if (strcmp(type, "16") == 0)
+        rel->setData(16);
     else if (strncmp(type, "32", 2) == 0) // for "32" and "32S"
-        set_le32(location, get_le32(location) + value);
+        rel->setData(32);
     else if (strcmp(type, "64") == 0)
-        set_le64(location, get_le64(location) + value);
-    else
-        super::relocate1(rel, location, value, type);
+        rel->setData(64);
 }
 
-void ElfLinkerArmBE::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
-                               const char *type) {
+void ElfLinkerArmBE::decodeRelocation(Relocation *rel) const {
+    const char *type = rel->type;
     if (!strcmp(type, "R_ARM_PC24") || !strcmp(type, "R_ARM_CALL") ||
         !strcmp(type, "R_ARM_JUMP24")) {
-        value -= rel->section->offset + rel->offset;
-        set_be24(1 + location, get_be24(1 + location) + value / 4);
+        rel->kind = RK_ARM_B24;
+        rel->pcrel = true;
     } else if (strcmp(type, "R_ARM_ABS32") == 0) {
-        set_be32(location, get_be32(location) + value);
+        rel->setData(32);
     } else if (strcmp(type, "R_ARM_THM_CALL") == 0 || strcmp(type, "R_ARM_THM_XPC22") == 0 ||
                strcmp(type, "R_ARM_THM_PC22") == 0) {
-        value -= rel->section->offset + rel->offset;
+        rel->kind = RK_ARM_THM_CALL;
+        rel->pcrel = true;
+    } else if (0 == strcmp("R_ARM_ABS8", type)) {
+        rel->setData(8);
+    }
+}
+
+void ElfLinkerArmBE::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
+                               const char *type) {
+    if (rel->kind == RK_ARM_B24) {
+        set_be24(1 + location, get_be24(1 + location) + value / 4);
+    } else if (rel->kind == RK_ARM_THM_CALL) {
         value += ((get_be16(location) & 0x7ff) << 12);
         value += (get_be16(location + 2) & 0x7ff) << 1;
 
@@ -634,23 +659,32 @@ void ElfLinkerArmBE::relocate1(const Relocation *rel, byte *location, upx_uint64
 
         //(b, 0xF000 + ((v - 1) / 2) * 0x10000);
         // set_be32(location, get_be32(location) + value / 4);
-    } else if (0 == strcmp("R_ARM_ABS8", type)) {
-        *location += value;
     } else
         super::relocate1(rel, location, value, type);
 }
 
-void ElfLinkerArmLE::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
-                               const char *type) {
+void ElfLinkerArmLE::decodeRelocation(Relocation *rel) const {
+    const char *type = rel->type;
     if (!strcmp(type, "R_ARM_PC24") || !strcmp(type, "R_ARM_CALL") ||
         !strcmp(type, "R_ARM_JUMP24")) {
-        value -= rel->section->offset + rel->offset;
-        set_le24(location, get_le24(location) + value / 4);
+        rel->kind = RK_ARM_B24;
+        rel->pcrel = true;
     } else if (strcmp(type, "R_ARM_ABS32") == 0) {
-        set_le32(location, get_le32(location) + value);
+        rel->setData(32);
     } else if (strcmp(type, "R_ARM_THM_CALL") == 0 || strcmp(type, "R_ARM_THM_XPC22") == 0 ||
                strcmp(type, "R_ARM_THM_PC22") == 0) {
-        value -= rel->section->offset + rel->offset;
+        rel->kind = RK_ARM_THM_CALL;
+        rel->pcrel = true;
+    } else if (0 == strcmp("R_ARM_ABS8", type)) {
+        rel->setData(8);
+    }
+}
+
+void ElfLinkerArmLE::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
+                               const char *type) {
+    if (rel->kind == RK_ARM_B24) {
+        set_le24(location, get_le24(location) + value / 4);
+    } else if (rel->kind == RK_ARM_THM_CALL) {
         value += ((get_le16(location) & 0x7ff) << 12);
         value += (get_le16(location + 2) & 0x7ff) << 1;
 
@@ -659,45 +693,56 @@ void ElfLinkerArmLE::relocate1(const Relocation *rel, byte *location, upx_uint64
 
         //(b, 0xF000 + ((v - 1) / 2) * 0x10000);
         // set_le32(location, get_le32(location) + value / 4);
-    } else if (0 == strcmp("R_ARM_ABS8", type)) {
-        *location += value;
     } else
         super::relocate1(rel, location, value, type);
 }
 
-void ElfLinkerArm64LE::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
-                                 const char *type) {
+void ElfLinkerArm64LE::decodeRelocation(Relocation *rel) const {
+    const char *type = rel->type;
     if (strncmp(type, "R_AARCH64_", 10))
-        return super::relocate1(rel, location, value, type);
+        return;
     type += 10;
 
     if (!strncmp(type, "PREL", 4)) {
-        value -= rel->section->offset + rel->offset;
+        rel->pcrel = true;
         type += 4;
 
         if (!strcmp(type, "16"))
-            set_le16(location, get_le16(location) + value);
+            rel->setData(16);
         else if (!strncmp(type, "32", 2)) // for "32" and "32S"
-            set_le32(location, get_le32(location) + value);
+            rel->setData(32);
         else if (!strcmp(type, "64"))
-            set_le64(location, get_le64(location) + value);
+            rel->setData(64);
+        else
+            rel->kind = RK_NONE; // historically ignored
     } else if (!strcmp(type, "ADR_PREL_LO21")) {
-        value -= rel->section->offset + rel->offset;
+        rel->kind = RK_ARM64_ADR_LO21;
+        rel->pcrel = true;
+    } else if (!strcmp(type, "ABS32")) {
+        rel->setData(32);
+    } else if (!strcmp(type, "ABS64")) {
+        rel->setData(64);
+    } else if (!strcmp(type, "CONDBR19")) {
+        rel->kind = RK_ARM64_CONDBR19;
+        rel->pcrel = true;
+    } else if (!strcmp(type, "CALL26") || !strcmp(type, "JUMP26")) {
+        rel->kind = RK_ARM64_CALL26;
+        rel->pcrel = true;
+    }
+}
+
+void ElfLinkerArm64LE::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
+                                 const char *type) {
+    if (rel->kind == RK_ARM64_ADR_LO21) {
         upx_uint32_t const m19 = ~(~0u << 19);
         upx_uint32_t w = get_le32(location);
         set_le32(location, (w & ~((3u << 29) | (m19 << 5))) | ((3u & value) << 29) |
                                ((m19 & (value >> 2)) << 5));
-    } else if (!strcmp(type, "ABS32")) {
-        set_le32(location, get_le32(location) + value);
-    } else if (!strcmp(type, "ABS64")) {
-        set_le64(location, get_le64(location) + value);
-    } else if (!strcmp(type, "CONDBR19")) {
-        value -= rel->section->offset + rel->offset;
+    } else if (rel->kind == RK_ARM64_CONDBR19) {
         upx_uint32_t const m19 = ~(~0u << 19);
         upx_uint32_t w = get_le32(location);
         set_le32(location, (w & ~(m19 << 5)) | ((((w >> 5) + (value >> 2)) & m19) << 5));
-    } else if (!strcmp(type, "CALL26") || !strcmp(type, "JUMP26")) {
-        value -= rel->section->offset + rel->offset;
+    } else if (rel->kind == RK_ARM64_CALL26) {
         upx_uint32_t const m26 = ~(~0u << 26);
         upx_uint32_t w = get_le32(location);
         set_le32(location, (w & ~m26) | (m26 & (value >> 2)));
@@ -817,30 +862,41 @@ unsigned ins_imm_RVC_JAL(unsigned w)  // RV32 only!
 #endif  //}
 // clang-format on
 
-void ElfLinkerRiscv64LE::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
-                                   const char *type) {
+void ElfLinkerRiscv64LE::decodeRelocation(Relocation *rel) const {
+    const char *type = rel->type;
     if (strncmp(type, "R_RISCV_", 8)) // not us
-        return super::relocate1(rel, location, value, type);
+        return;
     type += 8;
 
-    if (!strncmp(type, "BRANCH", 6)) {
-        value -= rel->section->offset + rel->offset;
+    if (!strncmp(type, "BRANCH", 6))
+        rel->kind = RK_RISCV_BRANCH;
+    else if (!strncmp(type, "JAL", 3))
+        rel->kind = RK_RISCV_JAL;
+    else if (!strncmp(type, "RVC_BRANCH", 10))
+        rel->kind = RK_RISCV_RVC_BRANCH;
+    else if (!strncmp(type, "RVC_JUMP", 8))
+        rel->kind = RK_RISCV_RVC_JUMP;
+    else if (!strncmp(type, "32", 2))
+        rel->kind = RK_RISCV_SET32;
+    rel->pcrel = rel->kind != RK_UNKNOWN && rel->kind != RK_RISCV_SET32;
+}
+
+void ElfLinkerRiscv64LE::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
+                                   const char *type) {
+    if (rel->kind == RK_RISCV_BRANCH) {
         unsigned instr = get_le32(location);
         set_le32(location,
                  (((037 << 20) | (037 << 15) | (7 << 12) | 0x7f) & instr) | ins_imm_RV_Bxx(value));
-    } else if (!strncmp(type, "JAL", 3)) {
-        value -= rel->section->offset + rel->offset;
+    } else if (rel->kind == RK_RISCV_JAL) {
         unsigned instr = get_le32(location);
         set_le32(location, (0xfff & instr) | ins_imm_RV_JAL(value));
-    } else if (!strncmp(type, "RVC_BRANCH", 10)) {
-        value -= rel->section->offset + rel->offset;
+    } else if (rel->kind == RK_RISCV_RVC_BRANCH) {
         unsigned instr = get_le16(location);
         set_le16(location, (((7 << 13) | (7 << 7) | 3) & instr) | ins_imm_RVC_Beq(value));
-    } else if (!strncmp(type, "RVC_JUMP", 8)) {
-        value -= rel->section->offset + rel->offset;
+    } else if (rel->kind == RK_RISCV_RVC_JUMP) {
         unsigned instr = get_le16(location);
         set_le16(location, (((7 << 13) | 3) & instr) | ins_imm_RVC_Jmp(value));
-    } else if (!strncmp(type, "32", 2)) {
+    } else if (rel->kind == RK_RISCV_SET32) {
         set_le32(location, value);
     } else
         super::relocate1(rel, location, value, type);
@@ -854,105 +910,124 @@ void ElfLinkerM68k::alignCode(unsigned len) {
     outputlen += len;
 }
 
-void ElfLinkerM68k::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
-                              const char *type) {
+void ElfLinkerM68k::decodeRelocation(Relocation *rel) const {
+    const char *type = rel->type;
     if (strncmp(type, "R_68K_", 6))
-        return super::relocate1(rel, location, value, type);
+        return;
     type += 6;
 
     if (strncmp(type, "PC", 2) == 0) {
-        value -= rel->section->offset + rel->offset;
+        rel->pcrel = true;
         type += 2;
     }
-    if (strcmp(type, "8") == 0) {
-        *location += value;
-    } else if (strcmp(type, "16") == 0) {
-        set_be16(location, get_be16(location) + value);
-    } else if (strcmp(type, "32") == 0) {
-        set_be32(location, get_be32(location) + value);
-    } else
-        super::relocate1(rel, location, value, type);
+    if (strcmp(type, "8") == 0)
+        rel->setData(8);
+    else if (strcmp(type, "16") == 0)
+        rel->setData(16);
+    else if (strcmp(type, "32") == 0)
+        rel->setData(32);
 }
 
-void ElfLinkerMipsBE::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
-                                const char *type) {
 #define MIPS_HI(a)   (((a) >> 16) + (((a) &0x8000) >> 15))
 #define MIPS_LO(a)   ((a) &0xffff)
 #define MIPS_PC16(a) ((a) >> 2)
 #define MIPS_PC26(a) (((a) &0x0fffffff) >> 2)
 
+void ElfLinkerMipsBE::decodeRelocation(Relocation *rel) const {
+    const char *type = rel->type;
     if (strcmp(type, "R_MIPS_HI16") == 0)
-        set_be16(2 + location, get_be16(2 + location) + MIPS_HI(value));
+        rel->kind = RK_MIPS_HI16;
     else if (strcmp(type, "R_MIPS_LO16") == 0)
-        set_be16(2 + location, get_be16(2 + location) + MIPS_LO(value));
+        rel->kind = RK_MIPS_LO16;
     else if (strcmp(type, "R_MIPS_PC16") == 0) {
-        value -= rel->section->offset + rel->offset;
-        set_be16(2 + location, get_be16(2 + location) + MIPS_PC16(value));
+        rel->kind = RK_MIPS_PC16;
+        rel->pcrel = true;
     } else if (strcmp(type, "R_MIPS_26") == 0)
-        set_be32(location, get_be32(location) + MIPS_PC26(value));
+        rel->kind = RK_MIPS_26;
     else if (strcmp(type, "R_MIPS_32") == 0)
-        set_be32(location, get_be32(location) + value);
+        rel->setData(32);
+}
+
+void ElfLinkerMipsBE::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
+                                const char *type) {
+    if (rel->kind == RK_MIPS_HI16)
+        set_be16(2 + location, get_be16(2 + location) + MIPS_HI(value));
+    else if (rel->kind == RK_MIPS_LO16)
+        set_be16(2 + location, get_be16(2 + location) + MIPS_LO(value));
+    else if (rel->kind == RK_MIPS_PC16)
+        set_be16(2 + location, get_be16(2 + location) + MIPS_PC16(value));
+    else if (rel->kind == RK_MIPS_26)
+        set_be32(location, get_be32(location) + MIPS_PC26(value));
     else
         super::relocate1(rel, location, value, type);
+}
 
-#undef MIPS_HI
-#undef MIPS_LO
-#undef MIPS_PC16
-#undef MIPS_PC26
+void ElfLinkerMipsLE::decodeRelocation(Relocation *rel) const {
+    const char *type = rel->type;
+    if (strcmp(type, "R_MIPS_HI16") == 0)
+        rel->kind = RK_MIPS_HI16;
+    else if (strcmp(type, "R_MIPS_LO16") == 0)
+        rel->kind = RK_MIPS_LO16;
+    else if (strcmp(type, "R_MIPS_PC16") == 0) {
+        rel->kind = RK_MIPS_PC16;
+        rel->pcrel = true;
+    } else if (strcmp(type, "R_MIPS_26") == 0)
+        rel->kind = RK_MIPS_26;
+    else if (strcmp(type, "R_MIPS_32") == 0)
+        rel->setData(32);
 }
 
 void ElfLinkerMipsLE::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
                                 const char *type) {
-#define MIPS_HI(a)   (((a) >> 16) + (((a) &0x8000) >> 15))
-#define MIPS_LO(a)   ((a) &0xffff)
-#define MIPS_PC16(a) ((a) >> 2)
-#define MIPS_PC26(a) (((a) &0x0fffffff) >> 2)
-
-    if (strcmp(type, "R_MIPS_HI16") == 0)
+    if (rel->kind == RK_MIPS_HI16)
         set_le16(location, get_le16(location) + MIPS_HI(value));
-    else if (strcmp(type, "R_MIPS_LO16") == 0)
+    else if (rel->kind == RK_MIPS_LO16)
         set_le16(location, get_le16(location) + MIPS_LO(value));
-    else if (strcmp(type, "R_MIPS_PC16") == 0) {
-        value -= rel->section->offset + rel->offset;
+    else if (rel->kind == RK_MIPS_PC16)
         set_le16(location, get_le16(location) + MIPS_PC16(value));
-    } else if (strcmp(type, "R_MIPS_26") == 0)
+    else if (rel->kind == RK_MIPS_26)
         set_le32(location, get_le32(location) + MIPS_PC26(value));
-    else if (strcmp(type, "R_MIPS_32") == 0)
-        set_le32(location, get_le32(location) + value);
     else
         super::relocate1(rel, location, value, type);
+}
 
 #undef MIPS_HI
 #undef MIPS_LO
 #undef MIPS_PC16
 #undef MIPS_PC26
-}
 
-void ElfLinkerPpc32::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
-                               const char *type) {
+void ElfLinkerPpc32::decodeRelocation(Relocation *rel) const {
+    const char *type = rel->type;
     if (strncmp(type, "R_PPC_", 6))
-        return super::relocate1(rel, location, value, type);
+        return;
     type += 6;
 
     if (strcmp(type, "ADDR32") == 0) {
-        set_be32(location, get_be32(location) + value);
+        rel->setData(32);
         return;
     }
 
     if (strncmp(type, "REL", 3) == 0) {
-        value -= rel->section->offset + rel->offset;
+        rel->pcrel = true;
         type += 3;
     }
 
     // FIXME: more relocs
+    if (strcmp(type, "24") == 0)
+        rel->kind = RK_PPC_B24;
+    else if (strcmp(type, "14") == 0)
+        rel->kind = RK_PPC_B14;
+}
 
+void ElfLinkerPpc32::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
+                               const char *type) {
     // Note that original (*location).displ is ignored.
-    if (strcmp(type, "24") == 0) {
+    if (rel->kind == RK_PPC_B24) {
         if (3 & value)
             throwInternalError("unaligned word displacement");
         // FIXME: displacement overflow?
         set_be32(location, (0xfc000003 & get_be32(location)) + (0x03fffffc & value));
-    } else if (strcmp(type, "14") == 0) {
+    } else if (rel->kind == RK_PPC_B14) {
         if (3 & value)
             throwInternalError("unaligned word displacement");
         // FIXME: displacement overflow?
@@ -961,130 +1036,127 @@ void ElfLinkerPpc32::relocate1(const Relocation *rel, byte *location, upx_uint64
         super::relocate1(rel, location, value, type);
 }
 
-void ElfLinkerPpc64le::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
-                                 const char *type) {
+void ElfLinkerPpc64le::decodeRelocation(Relocation *rel) const {
+    const char *type = rel->type;
     if (!strcmp(type, "R_PPC64_ADDR64")) {
-        set_le64(location, get_le64(location) + value);
+        rel->setData(64);
         return;
     }
     if (!strcmp(type, "R_PPC64_ADDR32")) {
-        set_le32(location, get_le32(location) + value);
+        rel->setData(32);
         return;
     }
     if (strncmp(type, "R_PPC64_REL", 11))
-        return super::relocate1(rel, location, value, type);
+        return;
     type += 11;
 
-    bool range_check = false;
     if (strncmp(type, "PC", 2) == 0) {
         type += 2;
-        range_check = true;
+        rel->range_check = true;
     }
 
     /* value will hold relative displacement */
-    value -= rel->section->offset + rel->offset;
+    rel->pcrel = true;
+
+    if (strncmp(type, "14", 2) == 0) // for "14" and "14S"
+        rel->kind = RK_PPC_B14;
+    else if (strncmp(type, "24", 2) == 0) // for "24" and "24S"
+        rel->kind = RK_PPC_B24;
+    else if (strcmp(type, "8") == 0)
+        rel->setData(8);
+    else if (strcmp(type, "16") == 0)
+        rel->setData(16);
+    else if (strncmp(type, "32", 2) == 0) // for "32" and "32S"
+        rel->setData(32);
+    else if (strcmp(type, "64") == 0)
+        rel->setData(64);
+}
 
-    if (strncmp(type, "14", 2) == 0) { // for "14" and "14S"
+void ElfLinkerPpc64le::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
+                                 const char *type) {
+    if (rel->kind == RK_PPC_B14) {
         if (3 & value)
             throwInternalError("unaligned word displacement");
         // FIXME: displacement overflow?
         set_le32(location, (0xffff0003 & get_le32(location)) + (0x0000fffc & value));
-    } else if (strncmp(type, "24", 2) == 0) { // for "24" and "24S"
+    } else if (rel->kind == RK_PPC_B24) {
         if (3 & value)
             throwInternalError("unaligned word displacement");
         // FIXME: displacement overflow?
         set_le32(location, (0xfc000003 & get_le32(location)) + (0x03fffffc & value));
-    } else if (strcmp(type, "8") == 0) {
-        int displ = (upx_int8_t) *location + (int) value;
-        if (range_check && (displ < -128 || displ > 127))
-            throwInternalError("target out of range (%d) in reloc %s:%x\n", displ,
-                               rel->section->name, rel->offset);
-        *location += value;
-    } else if (strcmp(type, "16") == 0)
-        set_le16(location, get_le16(location) + value);
-    else if (strncmp(type, "32", 2) == 0) // for "32" and "32S"
-        set_le32(location, get_le32(location) + value);
-    else if (strcmp(type, "64") == 0)
-        set_le64(location, get_le64(location) + value);
-    else
+    } else
         super::relocate1(rel, location, value, type);
 }
 
-void ElfLinkerPpc64::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
-                               const char *type) {
-    if (!strcmp(type, "R_PPC64_ADDR32")) {
-        set_be32(location, get_be32(location) + value);
+void ElfLinkerPpc64::decodeRelocation(Relocation *rel) const {
+    const char *type = rel->type;
+    if (!strcmp(type, "R_PPC64_ADDR64")) {
+        rel->setData(64);
         return;
     }
-    if (!strcmp(type, "R_PPC64_ADDR64")) {
-        set_be64(location, get_be64(location) + value);
+    if (!strcmp(type, "R_PPC64_ADDR32")) {
+        rel->setData(32);
         return;
     }
     if (strncmp(type, "R_PPC64_REL", 11))
-        return super::relocate1(rel, location, value, type);
+        return;
     type += 11;
 
-    bool range_check = false;
     if (strncmp(type, "PC", 2) == 0) {
         type += 2;
-        range_check = true;
+        rel->range_check = true;
     }
 
-    // We have "R_PPC64_REL" or "R_PPC64_RELPC" as a prefix.
     /* value will hold relative displacement */
-    value -= rel->section->offset + rel->offset;
+    rel->pcrel = true;
+
+    if (strncmp(type, "14", 2) == 0) // for "14" and "14S"
+        rel->kind = RK_PPC_B14;
+    else if (strncmp(type, "24", 2) == 0) // for "24" and "24S"
+        rel->kind = RK_PPC_B24;
+    else if (strcmp(type, "8") == 0)
+        rel->setData(8);
+    else if (strcmp(type, "16") == 0)
+        rel->setData(16);
+    else if (strncmp(type, "32", 2) == 0) // for "32" and "32S"
+        rel->setData(32);
+    else if (strcmp(type, "64") == 0)
+        rel->setData(64);
+}
 
-    if (strncmp(type, "14", 2) == 0) { // for "14" and "14S"
+void ElfLinkerPpc64::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
+                               const char *type) {
+    if (rel->kind == RK_PPC_B14) {
         if (3 & value)
             throwInternalError("unaligned word displacement");
         // FIXME: displacement overflow?
         set_be32(location, (0xffff0003 & get_be32(location)) + (0x0000fffc & value));
-    } else if (strncmp(type, "24", 2) == 0) { // for "24" and "24S"
+    } else if (rel->kind == RK_PPC_B24) {
         if (3 & value)
             throwInternalError("unaligned word displacement");
         // FIXME: displacement overflow?
         set_be32(location, (0xfc000003 & get_be32(location)) + (0x03fffffc & value));
-    } else if (strcmp(type, "8") == 0) {
-        int displ = (upx_int8_t) *location + (int) value;
-        if (range_check && (displ < -128 || displ > 127))
-            throwInternalError("target out of range (%d) in reloc %s:%x\n", displ,
-                               rel->section->name, rel->offset);
-        *location += value;
-    } else if (strcmp(type, "16") == 0)
-        set_be16(location, get_be16(location) + value);
-    else if (strncmp(type, "32", 2) == 0) // for "32" and "32S"
-        set_be32(location, get_be32(location) + value);
-    else if (strcmp(type, "64") == 0)
-        set_be64(location, get_be64(location) + value);
-    else
+    } else
         super::relocate1(rel, location, value, type);
 }
 
-void ElfLinkerX86::relocate1(const Relocation *rel, byte *location, upx_uint64_t value,
-                             const char *type) {
+void ElfLinkerX86::decodeRelocation(Relocation *rel) const {
+    const char *type = rel->type;
     if (strncmp(type, "R_386_", 6))
-        return super::relocate1(rel, location, value, type);
+        return;
     type += 6;
 
-    bool range_check = false;
     if (strncmp(type, "PC", 2) == 0) {
-        value -= rel->section->offset + rel->offset;
+        rel->pcrel = rel->range_check = true;
         type += 2;
-        range_check = true;
     }
 
-    if (strcmp(type, "8") == 0) {
-        int displ = (upx_int8_t) *location + (int) value;
-        if (range_check && (displ < -128 || displ > 127))
-            throwInternalError("target out of range (%d,%d,%llu) in reloc %s:%x\n", displ,
-                               *location, value, rel->section->name, rel->offset);
-        *location += value;
-    } else if (strcmp(type, "16") == 0)
-        set_le16(location, get_le16(location) + value);
+    if (strcmp(type, "8") == 0)
+        rel->setData(8);
+    else if (strcmp(type, "16") == 0)
+        rel->setData(16);
     else if (strcmp(type, "32") == 0)
-        set_le32(location, get_le32(location) + value);
-    else
-        super::relocate1(rel, location, value, type);
+        rel->setData(32);
 }
 
 /* vim:set ts=4 sw=4 et: */
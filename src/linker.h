@@ -110,7 +110,33 @@ public:
     }
 
 protected:
+    // relocation types are parsed once by decodeRelocation(), so that
+    // relocate() does not need any string compares
+    enum RelocKind : unsigned char {
+        RK_UNKNOWN = 0, // relocate1() throws
+        RK_NONE,        // ignored
+        RK_DATA,        // add value to a datum of Relocation::width bits
+        // arch specific instruction fields
+        RK_ARM_B24,
+        RK_ARM_THM_CALL,
+        RK_ARM64_ADR_LO21,
+        RK_ARM64_CONDBR19,
+        RK_ARM64_CALL26,
+        RK_MIPS_HI16,
+        RK_MIPS_LO16,
+        RK_MIPS_PC16,
+        RK_MIPS_26,
+        RK_PPC_B14,
+        RK_PPC_B24,
+        RK_RISCV_BRANCH,
+        RK_RISCV_JAL,
+        RK_RISCV_RVC_BRANCH,
+        RK_RISCV_RVC_JUMP,
+        RK_RISCV_SET32,
+    };
+    virtual void decodeRelocation(Relocation *) const {} // default: RK_UNKNOWN
     void relocate();
+    void relocateData(const Relocation *, byte *location, upx_uint64_t value) const;
     virtual void relocate1(const Relocation *, byte *location, upx_uint64_t value,
                            const char *type);
 };
@@ -144,10 +170,20 @@ struct ElfLinker::Relocation final : private upx::noncopyable {
     const char *type = nullptr;
     const Symbol *value = nullptr;
     upx_uint64_t add = 0; // used in .rela relocations
+    // set by decodeRelocation()
+    RelocKind kind = RK_UNKNOWN;
+    unsigned char width = 0;  // RK_DATA: 8, 16, 32 or 64
+    bool pcrel = false;       // value is relative to the location
+    bool range_check = false; // check 8-bit displacement
 
     explicit Relocation(const Section *s, unsigned o, const char *t, const Symbol *v,
                         upx_uint64_t a);
     ~Relocation() noexcept {}
+
+    void setData(unsigned w) {
+        kind = RK_DATA;
+        width = (unsigned char) w;
+    }
 };
 
 /*************************************************************************
@@ -158,13 +194,13 @@ class ElfLinkerAMD64 /*not_final*/ : public ElfLinker {
     typedef ElfLinker super;
 protected:
     virtual void alignCode(unsigned len) override { alignWithByte(len, 0x90); }
-    virtual void relocate1(const Relocation *, byte *location, upx_uint64_t value,
-                           const char *type) override;
+    virtual void decodeRelocation(Relocation *) const override;
 };
 
 class ElfLinkerArm64LE final : public ElfLinker {
     typedef ElfLinker super;
 protected:
+    virtual void decodeRelocation(Relocation *) const override;
     virtual void relocate1(const Relocation *, byte *location, upx_uint64_t value,
                            const char *type) override;
 };
@@ -172,6 +208,7 @@ protected:
 class ElfLinkerRiscv64LE final : public ElfLinker {
     typedef ElfLinker super;
 protected:
+    virtual void decodeRelocation(Relocation *) const override;
     virtual void relocate1(const Relocation *, byte *location, upx_uint64_t value,
                            const char *type) override;
 };
@@ -181,6 +218,7 @@ class ElfLinkerArmBE final : public ElfLinker {
 public:
     explicit ElfLinkerArmBE() noexcept : super(&N_BELE_RTP::be_policy) {}
 protected:
+    virtual void decodeRelocation(Relocation *) const override;
     virtual void relocate1(const Relocation *, byte *location, upx_uint64_t value,
                            const char *type) override;
 };
@@ -188,6 +226,7 @@ protected:
 class ElfLinkerArmLE final : public ElfLinker {
     typedef ElfLinker super;
 protected:
+    virtual void decodeRelocation(Relocation *) const override;
     virtual void relocate1(const Relocation *, byte *location, upx_uint64_t value,
                            const char *type) override;
 };
@@ -198,8 +237,7 @@ public:
     explicit ElfLinkerM68k() noexcept : super(&N_BELE_RTP::be_policy) {}
 protected:
     virtual void alignCode(unsigned len) override;
-    virtual void relocate1(const Relocation *, byte *location, upx_uint64_t value,
-                           const char *type) override;
+    virtual void decodeRelocation(Relocation *) const override;
 };
 
 class ElfLinkerMipsBE final : public ElfLinker {
@@ -207,6 +245,7 @@ class ElfLinkerMipsBE final : public ElfLinker {
 public:
     explicit ElfLinkerMipsBE() noexcept : super(&N_BELE_RTP::be_policy) {}
 protected:
+    virtual void decodeRelocation(Relocation *) const override;
     virtual void relocate1(const Relocation *, byte *location, upx_uint64_t value,
                            const char *type) override;
 };
@@ -214,6 +253,7 @@ protected:
 class ElfLinkerMipsLE final : public ElfLinker {
     typedef ElfLinker super;
 protected:
+    virtual void decodeRelocation(Relocation *) const override;
     virtual void relocate1(const Relocation *, byte *location, upx_uint64_t value,
                            const char *type) override;
 };
@@ -223,6 +263,7 @@ class ElfLinkerPpc32 final : public ElfLinker {
 public:
     explicit ElfLinkerPpc32() noexcept : super(&N_BELE_RTP::be_policy) {}
 protected:
+    virtual void decodeRelocation(Relocation *) const override;
     virtual void relocate1(const Relocation *, byte *location, upx_uint64_t value,
                            const char *type) override;
 };
@@ -232,6 +273,7 @@ class ElfLinkerPpc64 final : public ElfLinker {
 public:
     explicit ElfLinkerPpc64() noexcept : super(&N_BELE_RTP::be_policy) {}
 protected:
+    virtual void decodeRelocation(Relocation *) const override;
     virtual void relocate1(const Relocation *, byte *location, upx_uint64_t value,
                            const char *type) override;
 };
@@ -239,6 +281,7 @@ protected:
 class ElfLinkerPpc64le final : public ElfLinker {
     typedef ElfLinker super;
 protected:
+    virtual void decodeRelocation(Relocation *) const override;
     virtual void relocate1(const Relocation *, byte *location, upx_uint64_t value,
                            const char *type) override;
 };
@@ -247,8 +290,7 @@ class ElfLinkerX86 final : public ElfLinker {
     typedef ElfLinker super;
 protected:
     virtual void alignCode(unsigned len) override { alignWithByte(len, 0x90); }
-    virtual void relocate1(const Relocation *, byte *location, upx_uint64_t value,
-                           const char *type) override;
+    virtual void decodeRelocation(Relocation *) const override;
 };
 
 /* vim:set ts=4 sw=4 et: */
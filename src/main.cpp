@@ -198,6 +198,17 @@ static void check_and_update_options(int i, int argc) {
             e_usage();
         }
     }
+    if (opt->o_unix.extract_len && !opt->to_stdout && !opt->output_name) {
+        fprintf(stderr, "%s: '--extract-range' needs '-o' or '--stdout'\n", argv0);
+        e_usage();
+    }
+    if (opt->estimate && opt->cmd != CMD_COMPRESS) {
+        fprintf(stderr, "%s: '--estimate' only works when compressing\n", argv0);
+        e_usage();
+    }
+    check_not_both(opt->estimate, opt->output_name != nullptr, "--estimate", "-o");
+    check_not_both(opt->o_unix.preserve_symbols, opt->o_unix.android_shlib, "--preserve-symbols",
+                   "--android-shlib");
     check_not_both(opt->force_overwrite, opt->preserve_link, "--force-overwrite", "--link");
     check_not_both(opt->to_stdout, opt->preserve_link, "--stdout", "--link");
 
@@ -582,6 +593,28 @@ static int do_option(int optc, const char *arg) {
     case 525: // --exact
         opt->exact = true;
         break;
+    case 532: // --time-budget=
+        getoptvar(&opt->time_budget, 1u, 999999u, arg);
+        break;
+    case 533: // --optimize-for=
+        if (mfx_optarg && strcmp(mfx_optarg, "size") == 0)
+            opt->optimize_for = opt->OPTIMIZE_SIZE;
+        else if (mfx_optarg && strcmp(mfx_optarg, "balanced") == 0)
+            opt->optimize_for = opt->OPTIMIZE_BALANCED;
+        else if (mfx_optarg && strcmp(mfx_optarg, "startup") == 0)
+            opt->optimize_for = opt->OPTIMIZE_STARTUP;
+        else
+            e_optarg(arg);
+        break;
+    case 535:
+        opt->no_cache_pollution = true;
+        break;
+    case 536: // --threads=
+        getoptvar(&opt->threads, 0u, 256u, arg);
+        break;
+    case 537:
+        opt->estimate = true;
+        break;
     // CRP - Compression Runtime Parameters (undocumented and subject to change)
     case 801:
         getoptvar(&opt->crp.crp_ucl.c_flags, 0, 3, arg);
@@ -619,6 +652,9 @@ static int do_option(int optc, const char *arg) {
     case 816:
         getoptvar(&opt->crp.crp_lzma.num_fast_bytes, arg);
         break;
+    case 817:
+        getoptvar(&opt->crp.crp_lzma.match_finder, arg);
+        break;
     case 821:
         getoptvar(&opt->crp.crp_zlib.mem_level, arg);
         break;
@@ -698,7 +734,10 @@ static int do_option(int optc, const char *arg) {
         break;
     // o_unix
     case 660:
-        getoptvar(&opt->o_unix.blocksize, 8192u, ~0u, arg);
+        if (mfx_optarg && strcmp(mfx_optarg, "auto") == 0)
+            opt->o_unix.auto_blocksize = true;
+        else
+            getoptvar(&opt->o_unix.blocksize, 8192u, ~0u, arg);
         break;
     case 661:
         opt->o_unix.force_execve = true;
@@ -742,6 +781,31 @@ static int do_option(int optc, const char *arg) {
     case 679:
         opt->o_unix.catch_sigsegv = true;
         break;
+    case 680:
+        if (!mfx_optarg || !mfx_optarg[0])
+            e_optarg(arg);
+        opt->o_unix.base_file = mfx_optarg;
+        break;
+    case 681:
+        opt->o_unix.cdc_blocks = true;
+        break;
+    case 682:
+        opt->o_unix.preserve_symbols = true;
+        break;
+    case 683: { // --extract-range=ADDR:LEN
+        char *end = nullptr;
+        if (!mfx_optarg || !mfx_optarg[0])
+            e_optarg(arg);
+        opt->o_unix.extract_addr = strtoull(mfx_optarg, &end, 0);
+        if (end == mfx_optarg || *end != ':')
+            e_optarg(arg);
+        const char *const len = end + 1;
+        opt->o_unix.extract_len = strtoull(len, &end, 0);
+        if (end == len || *end || opt->o_unix.extract_len == 0 ||
+            opt->o_unix.extract_addr + opt->o_unix.extract_len < opt->o_unix.extract_addr)
+            e_optarg(arg);
+        set_cmd(CMD_DECOMPRESS);
+    } break;
     // ps1/exe
     case 670:
         opt->ps1_exe.boot_only = true;
@@ -905,6 +969,11 @@ int main_get_options(int argc, char **argv) {
         {"filter", 0x31, N, 521}, // --filter=
         {"no-filter", 0x10, N, 522},
         {"small", 0x10, N, 520},
+        {"time-budget", 0x31, N, 532}, // --time-budget=
+        {"optimize-for", 0x31, N, 533}, // --optimize-for=
+        {"no-cache-pollution", 0x10, N, 535},
+        {"threads", 0x31, N, 536}, // --threads=
+        {"estimate", 0x10, N, 537},
         // CRP - Compression Runtime Parameters (undocumented and subject to change)
         {"crp-nrv-cf", 0x31, N, 801},
         {"crp-nrv-sl", 0x31, N, 802},
@@ -925,6 +994,7 @@ int main_get_options(int argc, char **argv) {
         {"crp-lzma-lc", 0x31, N, 813},
         {"crp-lzma-ds", 0x31, N, 814},
         {"crp-lzma-fb", 0x31, N, 816},
+        {"crp-lzma-mf", 0x31, N, 817},
         {"crp-zlib-ml", 0x31, N, 821},
         {"crp-zlib-wb", 0x31, N, 822},
         {"crp-zlib-st", 0x31, N, 823},
@@ -958,6 +1028,10 @@ int main_get_options(int argc, char **argv) {
         {"force-pie", 0x90, N, 677},
         {"android-old", 0, N, 678},
         {"catch-sigsegv", 0, N, 679},
+        {"base", 0x31, N, 680},          // --base=
+        {"cdc-blocks", 0x10, N, 681},
+        {"preserve-symbols", 0, N, 682},
+        {"extract-range", 0x31, N, 683}, // --extract-range=
         // ps1/exe
         {"boot-only", 0x90, N, 670},
         {"no-align", 0x90, N, 671},
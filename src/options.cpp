@@ -56,6 +56,7 @@ void Options::reset() noexcept {
     o->preserve_ownership = true;
     o->preserve_timestamp = true;
     o->verbose = 2;
+    o->threads = 1; // every parallel trial needs its own output buffer
 
     o->console = CON_FILE;
 #if (ACC_OS_DOS32) && defined(__DJGPP__)
@@ -100,6 +101,7 @@ TEST_CASE("Options::reset") {
     Options *const o = &local_options;
     o->reset();
     CHECK(o->o_unix.osabi0 == 3);
+    CHECK(o->threads == 1);
     static_assert(TABLESIZE(o->win32_pe.compress_rt) == 25); // 25 == RT_LAST
     CHECK(o->win32_pe.compress_exports);
     CHECK(o->win32_pe.compress_icons);
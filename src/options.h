@@ -75,6 +75,13 @@ struct Options final {
     bool no_filter;   // force no filter
     bool prefer_ucl;  // prefer UCL
     bool exact;       // user requires byte-identical decompression
+    unsigned time_budget; // seconds per file for trying methods & filters; 0 == unlimited
+    // trade packed size against estimated decompression time
+    enum { OPTIMIZE_SIZE = 0, OPTIMIZE_BALANCED = 1, OPTIMIZE_STARTUP = 2 };
+    int optimize_for;
+    bool no_cache_pollution; // drop the page cache of files when done (batch runs)
+    unsigned threads;        // --threads: limit for all parallel work; 0 == number of CPUs
+    bool estimate;           // --estimate: only predict the result, write nothing
 
     // other options
     int backup;
@@ -152,6 +159,7 @@ struct Options final {
     } dos_exe;
     struct {
         unsigned blocksize;
+        bool auto_blocksize;    // --blocksize=auto: choose per extent
         bool force_execve;      // force the linux/386 execve format
         bool is_ptinterp;       // is PT_INTERP, so don't adjust auxv_t
         bool use_ptinterp;      // use PT_INTERP /opt/upx/run
@@ -159,10 +167,15 @@ struct Options final {
         bool unmap_all_pages;   // thus /proc/self/exe vanishes
         unsigned char osabi0;   // replacement if 0==.e_ident[EI_OSABI]
         bool preserve_build_id; // copy the build-id to the compressed binary
+        bool preserve_symbols;  // also copy .symtab/.strtab for symbolizers
         bool android_shlib;     // keep some ElfXX_Shdr for dlopen()
         bool android_old;       // < Android_10 ==> no memfd_create, inconsistent __NR_ftruncate
         bool force_pie;         // choose DF_1_PIE instead of is_shlib
         bool catch_sigsegv;     // to debug hardware or de-compressor
+        const char *base_file;  // re-use unchanged blocks of this packed file
+        bool cdc_blocks;        // content-defined block boundaries
+        upx_uint64_t extract_addr; // --extract-range=ADDR:LEN
+        upx_uint64_t extract_len;  // 0 ==> de-compress everything
     } o_unix;
     struct {
         bool boot_only;
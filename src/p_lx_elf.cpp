@@ -138,11 +138,15 @@ funpad4(InputFile *fi)
     return d;
 }
 
-static void alloc_file_image(MemBuffer &mb, off_t size)
+// Read the whole file into mb, at most once per packer: help1() runs
+// again from canPack() and canUnpack(), and the input does not change.
+static void read_file_image(MemBuffer &mb, InputFile *f, off_t size)
 {
     assert(mem_size_valid_bytes(size));
     if (mb.getVoidPtr() == nullptr) {
         mb.alloc(size);
+        f->seek(0, SEEK_SET);
+        f->readx(mb, size);
     } else {
         assert((u32_t)size <= mb.getSize());
     }
@@ -256,6 +260,8 @@ PackLinuxElf::PackLinuxElf(InputFile *f)
     o_elf_shnum(0)
 {
     memset(dt_table, 0, sizeof(dt_table));
+    dt_dup_mask = 0;
+    dt_ends.reset();
     symnum_max = 0;
     user_init_rp = nullptr;
 }
@@ -276,6 +282,62 @@ int PackLinuxElf64::is_LOAD(Elf64_Phdr const *phdr) const
     return PT_LOAD == get_te32(&phdr->p_type);
 }
 
+// --estimate: pack2() compresses the file contents of every PT_LOAD, and
+// pack3() the gap which follows it up to the next PT_LOAD or end-of-file
+// (see find_LOAD_gap()); that is where .symtab and debuginfo live.
+// Adjacent ranges are merged.
+unsigned PackLinuxElf32::getCompressedExtents(FileExtent *x, unsigned max) const
+{
+    unsigned n = 0;
+    Elf32_Phdr const *const phdr = phdri;
+    for (unsigned k = 0; phdr && k < e_phnum; ++k) if (is_LOAD(&phdr[k])) {
+        upx_uint64_t const lo = get_te32(&phdr[k].p_offset);
+        upx_uint64_t const end = lo + get_te32(&phdr[k].p_filesz);
+        upx_uint64_t hi = upx::umax(end, (upx_uint64_t)file_size);
+        for (unsigned j = 0; j < e_phnum; ++j) if (j != k && is_LOAD(&phdr[j])) {
+            upx_uint64_t const t = get_te32(&phdr[j].p_offset);
+            if (end <= t && t < hi)
+                hi = t;
+        }
+        if (n && (upx_uint64_t)(x[n-1].offset + x[n-1].size) == lo) {
+            x[n-1].size += hi - lo;
+            continue;
+        }
+        if (n >= max)
+            return 0;
+        x[n].offset = lo;
+        x[n].size   = hi - lo;
+        ++n;
+    }
+    return n;
+}
+
+unsigned PackLinuxElf64::getCompressedExtents(FileExtent *x, unsigned max) const
+{
+    unsigned n = 0;
+    Elf64_Phdr const *const phdr = phdri;
+    for (unsigned k = 0; phdr && k < e_phnum; ++k) if (is_LOAD(&phdr[k])) {
+        upx_uint64_t const lo = get_te64(&phdr[k].p_offset);
+        upx_uint64_t const end = lo + get_te64(&phdr[k].p_filesz);
+        upx_uint64_t hi = upx::umax(end, (upx_uint64_t)file_size);
+        for (unsigned j = 0; j < e_phnum; ++j) if (j != k && is_LOAD(&phdr[j])) {
+            upx_uint64_t const t = get_te64(&phdr[j].p_offset);
+            if (end <= t && t < hi)
+                hi = t;
+        }
+        if (n && (upx_uint64_t)(x[n-1].offset + x[n-1].size) == lo) {
+            x[n-1].size += hi - lo;
+            continue;
+        }
+        if (n >= max)
+            return 0;
+        x[n].offset = lo;
+        x[n].size   = hi - lo;
+        ++n;
+    }
+    return n;
+}
+
 void
 PackLinuxElf32::PackLinuxElf32help1(InputFile *f)
 {
@@ -319,16 +381,12 @@ PackLinuxElf32::PackLinuxElf32help1(InputFile *f)
 
     if (f && Elf32_Ehdr::ET_DYN!=e_type) {
         unsigned const len = file_size;  // (sz_phdrs + e_phoff) except --preserve-build-id
-        alloc_file_image(file_image, len);
-        f->seek(0, SEEK_SET);
-        f->readx(file_image, len);
+        read_file_image(file_image, f, len);
         phdri= (Elf32_Phdr       *)(e_phoff + file_image);  // do not free() !!
     }
     if (f && Elf32_Ehdr::ET_DYN==e_type) {
         // The DT_SYMTAB has no designated length.  Read the whole file.
-        alloc_file_image(file_image, file_size);
-        f->seek(0, SEEK_SET);
-        f->readx(file_image, file_size);
+        read_file_image(file_image, f, file_size);
         phdri= (Elf32_Phdr *)(e_phoff + file_image);  // do not free() !!
         if (opt->cmd != CMD_COMPRESS || !e_shoff ||  file_size < e_shoff) {
             shdri = nullptr;
@@ -1062,6 +1120,7 @@ PackLinuxElf64::PackLinuxElf64(InputFile *f)
     jni_onload_sym(nullptr),
     sec_strndx(nullptr), sec_dynsym(nullptr), sec_dynstr(nullptr)
     , sec_arm_attr(nullptr)
+    , sym_shnum(0)
 {
     memset(&ehdri, 0, sizeof(ehdri));
     n_jmp_slot = 0;
@@ -1126,16 +1185,12 @@ PackLinuxElf64::PackLinuxElf64help1(InputFile *f)
 
     if (f && Elf64_Ehdr::ET_DYN!=e_type) {
         unsigned const len = file_size;  // (sz_phdrs + e_phoff) except --preserve-build-id
-        alloc_file_image(file_image, len);
-        f->seek(0, SEEK_SET);
-        f->readx(file_image, len);
+        read_file_image(file_image, f, len);
         phdri= (Elf64_Phdr       *)(e_phoff + file_image);  // do not free() !!
     }
     if (f && Elf64_Ehdr::ET_DYN==e_type) {
         // The DT_SYMTAB has no designated length.  Read the whole file.
-        alloc_file_image(file_image, file_size);
-        f->seek(0, SEEK_SET);
-        f->readx(file_image, file_size);
+        read_file_image(file_image, f, file_size);
         phdri= (file_size <= (unsigned)e_phoff) ? nullptr : (Elf64_Phdr *)(e_phoff + file_image);  // do not free() !!
         if (!(opt->cmd == CMD_COMPRESS && e_shoff < (upx_uint64_t)file_size && mb_shdr.getSize() == 0)) {
             shdri = nullptr;
@@ -2422,6 +2477,9 @@ PackLinuxElf32::invert_pt_dynamic(Elf32_Dyn const *dynp, u32_t headway)
                 throwCantPack("duplicate DT_%#x: [%#x] [%#x]",
                     (unsigned)d_tag, -1+ dt_table[d_tag], ndx);
             }
+            if (dt_table[d_tag]) { // elf_find_dynptr() must scan for the first
+                dt_dup_mask |= (upx_uint64_t)1 << d_tag;
+            }
             dt_table[d_tag] = 1+ ndx;
         }
         if (Elf32_Dyn::DT_NULL == d_tag) {
@@ -2783,10 +2841,9 @@ tribool PackLinuxElf32::canUnpack() // bool, except -1: format known, but not pa
     if (get_te16(&ehdri.e_phnum) < 2) {
         throwCantUnpack("e_phnum must be >= 2");
     }
-    if (Elf32_Ehdr::ET_DYN==get_te16(&ehdri.e_type)) {
-        PackLinuxElf32help1(fi);
-    }
+    // checkEhdr() has matched e_machine; read the file only if it is packed
     if (super::canUnpack()) {
+        PackLinuxElf32help1(fi);  // the constructor only probed the Ehdr
         return true;
     }
     return false;
@@ -3201,6 +3258,8 @@ tribool PackLinuxElf32::canPack()
     // now check the ELF header
     if (checkEhdr(ehdr) != 0)
         return false;
+    PackLinuxElf32help1(fi);  // the constructor only probed the Ehdr
+    fi->seek(0, SEEK_SET);
 
     // additional requirements for linux/elf386
     if (get_te16(&ehdr->e_ehsize) != sizeof(*ehdr)) {
@@ -3276,9 +3335,7 @@ tribool PackLinuxElf32::canPack()
 
     if (Elf32_Ehdr::ET_DYN==get_te16(&ehdr->e_type)) {
         // The DT_SYMTAB has no designated length.  Read the whole file.
-        alloc_file_image(file_image, file_size);
-        fi->seek(0, SEEK_SET);
-        fi->readx(file_image, file_size);
+        read_file_image(file_image, fi, file_size);
         memcpy(&ehdri, ehdr, sizeof(Elf32_Ehdr));
         phdri= (Elf32_Phdr *)((size_t)e_phoff + file_image);  // do not free() !!
         shdri= (Elf32_Shdr *)((size_t)e_shoff + file_image);  // do not free() !!
@@ -3487,10 +3544,9 @@ tribool PackLinuxElf64::canUnpack() // bool, except -1: format known, but not pa
     if (get_te16(&ehdri.e_phnum) < 2) {
         throwCantUnpack("e_phnum must be >= 2");
     }
-    if (Elf64_Ehdr::ET_DYN==get_te16(&ehdri.e_type)) {
-        PackLinuxElf64help1(fi);
-    }
+    // checkEhdr() has matched e_machine; read the file only if it is packed
     if (super::canUnpack()) {
+        PackLinuxElf64help1(fi);  // the constructor only probed the Ehdr
         return true;
     }
     return false;
@@ -3511,6 +3567,8 @@ tribool PackLinuxElf64::canPack()
     // now check the ELF header
     if (checkEhdr(ehdr) != 0)
         return false;
+    PackLinuxElf64help1(fi);  // the constructor only probed the Ehdr
+    fi->seek(0, SEEK_SET);
 
     // additional requirements for linux/elf386
     if (get_te16(&ehdr->e_ehsize) != sizeof(*ehdr)) {
@@ -3585,9 +3643,7 @@ tribool PackLinuxElf64::canPack()
 
     if (Elf64_Ehdr::ET_DYN==get_te16(&ehdr->e_type)) {
         // The DT_SYMTAB has no designated length.  Read the whole file.
-        alloc_file_image(file_image, file_size);
-        fi->seek(0, SEEK_SET);
-        fi->readx(file_image, file_size);
+        read_file_image(file_image, fi, file_size);
         memcpy(&ehdri, ehdr, sizeof(Elf64_Ehdr));
         phdri= (Elf64_Phdr *)((size_t)e_phoff + file_image);  // do not free() !!
         shdri= (Elf64_Shdr *)((size_t)e_shoff + file_image);  // do not free() !!
@@ -5377,6 +5433,9 @@ void PackLinuxElf64::pack1(OutputFile * /*fo*/, Filter &ft)
             set_te64(&shdrout.shdr[2].sh_size, 29); //size of our static shstrtab; UPX_RSIZE_MAX_MEM
         }
     }
+    if (opt->o_unix.preserve_symbols && !opt->o_unix.android_shlib) {
+        collect_symbol_Shdrs();
+    }
 }
 
 void PackLinuxElf64amd::pack1(OutputFile *fo, Filter &ft)
@@ -6592,6 +6651,128 @@ unsigned PackLinuxElf64::forward_Shdrs(OutputFile *fo, Elf64_Ehdr *const eho)
     return penalty;
 }
 
+// --preserve-symbols: keep the whole Shdr table, as "strip --only-keep-debug"
+// does.  Only .symtab, .strtab, .shstrtab and .note.gnu.build-id (or
+// .dynsym and .dynstr when there is no .symtab) keep their bytes; every
+// other section becomes SHT_NOBITS.  Section numbers and .sh_addr do not
+// change, so .st_shndx and .st_value still describe the de-compressed
+// program, and a symbolizer can use the packed file as its own debug file.
+void PackLinuxElf64::collect_symbol_Shdrs()
+{
+    unsigned const shnum = get_te16(&ehdri.e_shnum);
+    unsigned const shstrndx = get_te16(&ehdri.e_shstrndx);
+    upx_uint64_t const shoff = get_te64(&ehdri.e_shoff);
+    if (!shnum || !shoff || shstrndx >= shnum
+    ||  sizeof(Elf64_Shdr) != get_te16(&ehdri.e_shentsize)
+    ||  (upx_uint64_t)file_size < shoff
+    ||  ((upx_uint64_t)file_size - shoff) / sizeof(Elf64_Shdr) < shnum) {
+        infoWarning("--preserve-symbols: no usable section headers");
+        return;
+    }
+    mb_sym_shdrs.alloc(mem_size(sizeof(Elf64_Shdr), shnum));
+    Elf64_Shdr *const sho = (Elf64_Shdr *)mb_sym_shdrs.getVoidPtr();
+    fi->seek(shoff, SEEK_SET);
+    fi->readx(sho, shnum * sizeof(Elf64_Shdr));
+
+    // keep[j]: the bytes of section j are copied
+    MemBuffer mb_keep(shnum);
+    unsigned char *const keep = (unsigned char *)mb_keep.getVoidPtr();
+    memset(keep, 0, shnum);
+    keep[shstrndx] = 1;
+
+    upx_uint64_t const names_size = get_te64(&sho[shstrndx].sh_size);
+    upx_uint64_t const names_offset = get_te64(&sho[shstrndx].sh_offset);
+    MemBuffer mb_names(mem_size(1, names_size, 1));
+    mb_names.clear();
+    if (names_offset <= (upx_uint64_t)file_size
+    &&  names_size <= (upx_uint64_t)file_size - names_offset) {
+        fi->seek(names_offset, SEEK_SET);
+        fi->readx(mb_names, names_size);
+    }
+    char const *const names = (char const *)mb_names.getVoidPtr();
+
+    bool has_symtab = false;
+    for (unsigned j = 1; j < shnum; ++j) {
+        has_symtab |= (Elf64_Shdr::SHT_SYMTAB == get_te32(&sho[j].sh_type));
+    }
+    unsigned const want_sym = has_symtab ? Elf64_Shdr::SHT_SYMTAB : Elf64_Shdr::SHT_DYNSYM;
+    for (unsigned j = 1; j < shnum; ++j) {
+        unsigned const type = get_te32(&sho[j].sh_type);
+        unsigned const name = get_te32(&sho[j].sh_name);
+        if (want_sym == type) {
+            unsigned const link = get_te32(&sho[j].sh_link);
+            if (link < shnum)
+                keep[link] = 1;  // its string table
+            keep[j] = 1;
+        }
+        if (Elf64_Shdr::SHT_NOTE == type && name < names_size
+        &&  !strcmp(".note.gnu.build-id", &names[name])) {
+            keep[j] = 1;
+        }
+    }
+
+    upx_uint64_t total = 0;
+    for (unsigned j = 1; j < shnum; ++j) {
+        upx_uint64_t const sh_offset = get_te64(&sho[j].sh_offset);
+        upx_uint64_t const sh_size = get_te64(&sho[j].sh_size);
+        if (keep[j] && Elf64_Shdr::SHT_NOBITS != get_te32(&sho[j].sh_type)
+        &&  sh_offset <= (upx_uint64_t)file_size
+        &&  sh_size <= (upx_uint64_t)file_size - sh_offset) {
+            total = ~7ull & (7 + total + sh_size);
+        }
+        else {
+            keep[j] = 0;
+        }
+    }
+    if (total > UPX_RSIZE_MAX_MEM) {
+        throwCantPack("--preserve-symbols: symbol tables too big");
+    }
+    mb_sym_data.alloc(1 + total);  // never 0 bytes
+    mb_sym_data.clear();
+    unsigned pos = 0;
+    for (unsigned j = 1; j < shnum; ++j) {
+        Elf64_Shdr *const sh = &sho[j];
+        if (keep[j]) {
+            unsigned const sh_size = get_te64(&sh->sh_size);
+            fi->seek(get_te64(&sh->sh_offset), SEEK_SET);
+            fi->readx(pos + (char *)mb_sym_data.getVoidPtr(), sh_size);
+            set_te64(&sh->sh_offset, pos);  // relative until write_symbol_Shdrs()
+            set_te64(&sh->sh_flags, ~(upx_uint64_t)Elf64_Shdr::SHF_ALLOC & get_te64(&sh->sh_flags));
+            pos = up8(pos + sh_size);
+        }
+        else {
+            set_te32(&sh->sh_type, Elf64_Shdr::SHT_NOBITS);
+            sh->sh_offset = 0;
+        }
+    }
+    sym_shnum = shnum;
+    if (!has_symtab) {
+        infoWarning("--preserve-symbols: no .symtab, keeping .dynsym");
+    }
+}
+
+// Append the contents collected by collect_symbol_Shdrs(), then the Shdr table.
+void PackLinuxElf64::write_symbol_Shdrs(OutputFile *fo, Elf64_Ehdr *const eho)
+{
+    Elf64_Shdr *const sho = (Elf64_Shdr *)mb_sym_shdrs.getVoidPtr();
+    total_out = fpad8(fo, total_out);
+    unsigned const base = total_out;
+    unsigned const len = mb_sym_data.getSize() - 1;
+    fo->write(mb_sym_data, len); total_out += len;
+    for (unsigned j = 1; j < sym_shnum; ++j) {
+        if (Elf64_Shdr::SHT_NOBITS != get_te32(&sho[j].sh_type)) {
+            set_te64(&sho[j].sh_offset, base + get_te64(&sho[j].sh_offset));
+        }
+    }
+    total_out = fpad8(fo, total_out);
+    set_te64(&eho->e_shoff, total_out);
+    set_te16(&eho->e_shentsize, sizeof(Elf64_Shdr));
+    set_te16(&eho->e_shnum, sym_shnum);
+    eho->e_shstrndx = ehdri.e_shstrndx;
+    unsigned const sz_shdrs = sym_shnum * sizeof(Elf64_Shdr);
+    fo->write(sho, sz_shdrs); total_out += sz_shdrs;
+}
+
 void PackLinuxElf32::pack4(OutputFile *fo, Filter &ft)
 {
     if (!xct_off) {
@@ -6681,7 +6862,10 @@ void PackLinuxElf64::pack4(OutputFile *fo, Filter &ft)
             : (cprElfHdr4 *)lowmem.getVoidPtr();  // shlib
     unsigned penalty = forward_Shdrs(fo, &eho->ehdr); (void)penalty;
 
-    if (opt->o_unix.preserve_build_id) { // FIXME: co-ordinate with forward_Shdrs
+    if (sym_shnum) { // includes the build-id, if any
+        write_symbol_Shdrs(fo, &eho->ehdr);
+    }
+    else if (opt->o_unix.preserve_build_id) { // FIXME: co-ordinate with forward_Shdrs
         // calc e_shoff here and write shdrout, then o_shstrtab
         //NOTE: these are pushed last to ensure nothing is stepped on
         //for the UPX structure.
@@ -6715,7 +6899,7 @@ void PackLinuxElf64::pack4(OutputFile *fo, Filter &ft)
                 set_te32(&phdro->p_flags, Elf64_Phdr::PF_X | get_te32(&phdro->p_flags));
             }
         }
-        if (!sec_arm_attr && !saved_opt_android_shlib) {
+        if (!sec_arm_attr && !saved_opt_android_shlib && !sym_shnum) {
             // Make it abundantly clear that there are no Elf64_Shdr in this shlib
             eho->ehdr.e_shoff = 0;
             set_te16(&eho->ehdr.e_shentsize, sizeof(Elf64_Shdr));  // Android bug: cannot use 0
@@ -7437,6 +7621,7 @@ void PackLinuxElf32::un_DT_INIT(
                 if (!old_dtinit) { // compressor took the slot
                     dyn->d_tag = Elf32_Dyn::DT_NULL;
                     dyn->d_val = 0;
+                    dt_table[Elf32_Dyn::DT_NULL] = 1+ (dyn - dynseg);  // for elf_find_dynptr()
                 }
             }
             // Apparently the hard case is common for some Android IDEs.
@@ -7623,6 +7808,7 @@ void PackLinuxElf64::un_DT_INIT(
                 if (!old_dtinit) { // compressor took the slot
                     dyn->d_tag = Elf64_Dyn::DT_NULL;
                     dyn->d_val = 0;
+                    dt_table[Elf64_Dyn::DT_NULL] = 1+ (dyn - dynseg);  // for elf_find_dynptr()
                 }
             }
             // Apparently the hard case is common for some Android IDEs.
@@ -7721,6 +7907,64 @@ void PackLinuxElf64::un_DT_INIT(
     }
 }
 
+// --extract-range=ADDR:LEN: write bytes [ADDR, ADDR+LEN) of the
+// de-compressed program (by virtual address) without de-compressing
+// everything.  The b_info headers are the index: each PT_LOAD is a run of
+// blocks, and a block which does not overlap the range is skipped by
+// seeking over its sz_cpr bytes.  Only the covering blocks are read and
+// de-compressed.  On entry, 'fi' is at the first b_info.
+// The output is NOT verified: the only checksums (ph.c_adler, ph.u_adler)
+// cover the whole stream, and b_info has none per block.
+void PackLinuxElf64::unpack_range(OutputFile *fo, Elf64_Phdr const *phdr, unsigned u_phnum)
+{
+    if (12 != szb_info) {  // ancient per-file filter needs the whole stream
+        throwCantUnpack("--extract-range: packed by a too old version");
+    }
+    upx_uint64_t const lo = opt->o_unix.extract_addr;
+    upx_uint64_t const hi = lo + opt->o_unix.extract_len;
+    upx_uint64_t done = lo;  // next address to write
+    for (unsigned j = 0; j < u_phnum && done < hi; ++phdr, ++j) {
+        if (!is_LOAD(phdr)) {
+            continue;
+        }
+        upx_uint64_t va = get_te64(&phdr->p_vaddr);
+        upx_uint64_t left = get_te64(&phdr->p_filesz);
+        while (left && done < hi) {
+            upx_off_t const where = fi->tell();
+            b_info hdr; memset(&hdr, 0, sizeof(hdr));
+            fi->readx(&hdr, szb_info);
+            unsigned const sz_unc = get_te32(&hdr.sz_unc);
+            unsigned const sz_cpr = get_te32(&hdr.sz_cpr);
+            if (!sz_unc || !sz_cpr || sz_cpr > sz_unc || sz_unc > blocksize || sz_unc > left) {
+                throwCantUnpack("corrupt b_info");
+            }
+            if (va + sz_unc <= done || hi <= va) { // no overlap: skip
+                fi->seek(sz_cpr, SEEK_CUR);
+            }
+            else {
+                if (done < va) { // hole between PT_LOADs, or .bss
+                    throwCantUnpack("--extract-range: %#llx is not in the file",
+                        (unsigned long long)done);
+                }
+                fi->seek(where, SEEK_SET);
+                unsigned c_adler = upx_adler32(nullptr, 0);  // unused; see above
+                unsigned u_adler = upx_adler32(nullptr, 0);
+                unpackExtent(sz_unc, nullptr, c_adler, u_adler, false, -1);  // to ibuf[0, sz_unc)
+                upx_uint64_t const end = umin(va + sz_unc, hi);
+                unsigned const len = end - done;
+                fo->write(ibuf + (unsigned)(done - va), len);
+                total_out += len;
+                done = end;
+            }
+            va += sz_unc;
+            left -= sz_unc;
+        }
+    }
+    if (done < hi) {
+        throwCantUnpack("--extract-range: %#llx is not in the file", (unsigned long long)done);
+    }
+}
+
 void PackLinuxElf64::unpack(OutputFile *fo)
 {
     if (e_phoff != sizeof(Elf64_Ehdr)) {// Phdrs not contiguous with Ehdr
@@ -7797,6 +8041,9 @@ void PackLinuxElf64::unpack(OutputFile *fo)
     // dynseg was set by PackLinuxElf64help1
     if (dynhdr && !(Elf64_Dyn::DF_1_PIE & elf_unsigned_dynamic(Elf64_Dyn::DT_FLAGS_1))) {
         // Packed shlib? (ET_DYN without -fPIE)
+        if (opt->o_unix.extract_len) {
+            throwCantUnpack("--extract-range: not supported for shared libraries");
+        }
         is_shlib = 1;
         xct_off = overlay_offset - sizeof(l_info);
         u_phnum = get_te16(&ehdri.e_phnum);
@@ -7852,6 +8099,10 @@ void PackLinuxElf64::unpack(OutputFile *fo)
         }
         o_elfhdrs.alloc(sizeof(Elf64_Ehdr) + u_phnum * sizeof(Elf64_Phdr));
         memcpy(o_elfhdrs, ehdr, o_elfhdrs.getSize());
+        if (opt->o_unix.extract_len) {
+            unpack_range(fo, (Elf64_Phdr const *)(void const *)(1+ ehdr), u_phnum);
+            return;
+        }
 
         // Decompress each PT_LOAD.
         bool first_PF_X = true;
@@ -7987,9 +8238,7 @@ void PackLinuxElf64::unpack(OutputFile *fo)
                     if (is_be) {
                         // Does the right thing for sz_unc and sz_cpr,
                         // but swaps b_method and b_extra.  Need find_be32() :-)
-                        for (unsigned k = 0; k < N_PEEK; k += sizeof(int)) {
-                            set_le32(&peek_arr[k], get_be32(&peek_arr[k]));
-                        }
+                        bswap32_array(peek_arr, N_PEEK / sizeof(int));
                     }
                     int boff = find_le32(peek_arr, sizeof(peek_arr), size);
                     if (boff < 0
@@ -8303,6 +8552,16 @@ PackLinuxElf32::check_pt_dynamic(Elf32_Phdr const *const phdr)
 Elf32_Dyn *PackLinuxElf32::elf_find_dynptr(unsigned int key) const
 {
     Elf32_Dyn *dynp= dynseg;
+    if (dynp && key < DT_NUM && Elf32_Dyn::DT_NULL != key && Elf32_Dyn::DT_NEEDED != key
+    &&  !((dt_dup_mask >> key) & 1)
+    &&  dt_table[key] && dt_table[key] < dt_table[Elf32_Dyn::DT_NULL]) {
+        // O(1) via dt_table[] from invert_pt_dynamic(); but the tags may have
+        // been edited in place since then, so trust only a confirmed hit.
+        Elf32_Dyn *const hit = &dynp[-1+ dt_table[key]];
+        if (get_te32(&hit->d_tag) == key) {
+            return hit;
+        }
+    }
     if (dynp) {
         Elf32_Dyn *const last = (Elf32_Dyn *)(sz_dynseg + (char *)dynseg);
         for (; dynp < last; ++dynp) {
@@ -8320,6 +8579,16 @@ Elf32_Dyn *PackLinuxElf32::elf_find_dynptr(unsigned int key) const
 Elf64_Dyn *PackLinuxElf64::elf_find_dynptr(unsigned int key) const
 {
     Elf64_Dyn *dynp= dynseg;
+    if (dynp && key < DT_NUM && Elf64_Dyn::DT_NULL != key && Elf64_Dyn::DT_NEEDED != key
+    &&  !((dt_dup_mask >> key) & 1)
+    &&  dt_table[key] && dt_table[key] < dt_table[Elf64_Dyn::DT_NULL]) {
+        // O(1) via dt_table[] from invert_pt_dynamic(); but the tags may have
+        // been edited in place since then, so trust only a confirmed hit.
+        Elf64_Dyn *const hit = &dynp[-1+ dt_table[key]];
+        if (get_te64(&hit->d_tag) == key) {
+            return hit;
+        }
+    }
     if (dynp) {
         Elf64_Dyn *const last = (Elf64_Dyn *)(sz_dynseg + (char *)dynseg);
         for (; dynp < last; ++dynp) {
@@ -8566,6 +8835,9 @@ PackLinuxElf64::invert_pt_dynamic(Elf64_Dyn const *dynp, upx_uint64_t headway)
                 throwCantPack("duplicate DT_%#x: [%#x] [%#x]",
                     (unsigned)d_tag, -1+ dt_table[d_tag], ndx);
             }
+            if (dt_table[d_tag]) { // elf_find_dynptr() must scan for the first
+                dt_dup_mask |= (upx_uint64_t)1 << d_tag;
+            }
             dt_table[d_tag] = 1+ ndx;
         }
         if (Elf64_Dyn::DT_NULL == d_tag) {
@@ -8740,6 +9012,50 @@ PackLinuxElf64::invert_pt_dynamic(Elf64_Dyn const *dynp, upx_uint64_t headway)
     }
 }
 
+// dt_offsets[0..n] is sorted, and ends with the sentinel image_size
+void ElfDtEnds::find(unsigned const *dt_offsets, unsigned n, char const *image,
+    upx_uint64_t image_size, void const *hash, void const *sym)
+{
+    if (hash == key[0] && sym == key[1]) {
+        return;  // already done for this pair
+    }
+    key[0] = hash; key[1] = sym;
+    ++scans;
+    void const *l_hash = nullptr, *l_sym = nullptr;
+    for (unsigned j = 0; j < n; ++j) {
+        void const *const ptr = dt_offsets[j] + image;
+        if (!l_hash && hash == ptr) {
+            l_hash = dt_offsets[1+ j] + image;
+        }
+        if (!l_sym && sym == ptr) {
+            l_sym = dt_offsets[1+ j] + image;
+        }
+        if (l_sym && l_hash)
+            break;  // found both
+        if (image_size == dt_offsets[j])
+            break;  // end sentinel
+    }
+    hash_end = l_hash;
+    sym_end = l_sym;
+}
+
+TEST_CASE("ElfDtEnds") {
+    static const char image[64] = {};
+    unsigned const offsets[] = {8, 16, 24, 40, 64, 64};
+    ElfDtEnds e;
+    e.reset();
+    e.find(offsets, 5, image, 64, image + 16, image + 24);
+    CHECK(e.hash_end == image + 24);
+    CHECK(e.sym_end == image + 40);
+    CHECK(e.scans == 1);
+    e.find(offsets, 5, image, 64, image + 16, image + 24);
+    CHECK(e.scans == 1);  // memoized
+    e.find(offsets, 5, image, 64, image + 40, image + 20);
+    CHECK(e.scans == 2);  // new pair
+    CHECK(e.hash_end == image + 64);
+    CHECK(e.sym_end == nullptr);  // not a table start
+}
+
 unsigned PackLinuxElf::gnu_hash(char const *q)
 {
     unsigned char const *p = (unsigned char const *)q;
@@ -8773,20 +9089,9 @@ Elf32_Sym const *PackLinuxElf32::elf_lookup(char const *name) const
         unsigned const *const chains = &buckets[n_bucket];
         // Find the end of DT_HASH and DT_DYNSYM. Perhaps elf_find_table_size()
         // depends on too many valid input values?
-        void const *l_hash = nullptr, *l_sym = nullptr;
-        for (unsigned j = 0; j < DT_NUM; ++j) {
-            void const *const ptr = dt_offsets[j] + (char const *)file_image.getVoidPtr();
-            if (!l_hash && hashtab == ptr) {
-                l_hash = dt_offsets[1+ j] + (char const *)file_image.getVoidPtr();
-            }
-            if (!l_sym && dynsym == ptr) {
-                l_sym = dt_offsets[1+ j] + (char const *)file_image.getVoidPtr();
-            }
-            if (l_sym && l_hash)
-                break;  // found both
-            if (this->file_size == (off_t)dt_offsets[j])
-                break;  // end sentinel
-        }
+        dt_ends.find(dt_offsets, DT_NUM, (char const *)file_image.getVoidPtr(),
+            file_size, hashtab, dynsym);
+        void const *const l_hash = dt_ends.hash_end, *const l_sym = dt_ends.sym_end;
         if (n_bucket) {
             void const *EOM = file_size + (char const *)file_image.getVoidPtr();
             unsigned const m = elf_hash(name) % n_bucket;
@@ -8878,20 +9183,9 @@ Elf64_Sym const *PackLinuxElf64::elf_lookup(char const *name) const
         unsigned const *const chains = &buckets[n_bucket];
         // Find the end of DT_HASH and DT_DYNSYM. Perhaps elf_find_table_size()
         // depends on too many valid input values?
-        void const *l_hash = nullptr, *l_sym = nullptr;
-        for (unsigned j = 0; j < DT_NUM; ++j) {
-            void const *const ptr = dt_offsets[j] + (char const *)file_image.getVoidPtr();
-            if (!l_hash && hashtab == ptr) {
-                l_hash = dt_offsets[1+ j] + (char const *)file_image.getVoidPtr();
-            }
-            if (!l_sym && dynsym == ptr) {
-                l_sym = dt_offsets[1+ j] + (char const *)file_image.getVoidPtr();
-            }
-            if (l_sym && l_hash)
-                break;  // found both
-            if (this->file_size == (off_t)dt_offsets[j])
-                break;  //end
-        }
+        dt_ends.find(dt_offsets, DT_NUM, (char const *)file_image.getVoidPtr(),
+            file_size, hashtab, dynsym);
+        void const *const l_hash = dt_ends.hash_end, *const l_sym = dt_ends.sym_end;
         if (n_bucket) { // -rust-musl can have "empty" hashtab
             void const *const EOM = file_size + (char const *)file_image.getVoidPtr();
             unsigned const m = elf_hash(name) % n_bucket;
@@ -9220,9 +9514,7 @@ void PackLinuxElf32::unpack(OutputFile *fo)
                     if (is_be) {
                         // Does the right thing for sz_unc and sz_cpr,
                         // but swaps b_method and b_extra.  Need find_be32() :-)
-                        for (unsigned k = 0; k < N_PEEK; k += sizeof(int)) {
-                            set_le32(&peek_arr[k], get_be32(&peek_arr[k]));
-                        }
+                        bswap32_array(peek_arr, N_PEEK / sizeof(int));
                     }
                     int boff = find_le32(peek_arr, sizeof(peek_arr), size);
                     if (boff < 0 || sizeof(peek_arr) < (sizeof(*bp) + boff)) {
@@ -37,6 +37,17 @@
 typedef upx_uint32_t u32_t;  // easier to type; more narrow
 typedef upx_uint64_t u64_t;  // easier to type; more narrow
 
+// The ends of DT_HASH and DT_SYMTAB according to the sorted dt_offsets[],
+// memoized per {hashtab, dynsym} for elf_lookup().
+struct ElfDtEnds {
+    void const *key[2];  // {hashtab, dynsym} of hash_end, sym_end
+    void const *hash_end, *sym_end;
+    unsigned scans;  // number of times dt_offsets[] was scanned
+    void reset() { key[0] = key[1] = hash_end = sym_end = nullptr; scans = 0; }
+    void find(unsigned const *dt_offsets, unsigned n, char const *image,
+        upx_uint64_t image_size, void const *hash, void const *sym);
+};
+
 class PackLinuxElf : public PackUnix
 {
     typedef PackUnix super;
@@ -90,6 +101,7 @@ protected:
     MemBuffer mb_shdr;      // Shdr might not be near Phdr
     MemBuffer mb_dt_offsets;  // file offset of various DT_ tables
     unsigned *dt_offsets;  // index by dt_table[]
+    mutable ElfDtEnds dt_ends;  // for elf_lookup()
     unsigned symnum_max;
     unsigned strtab_max;
     char const *dynstr;   // from DT_STRTAB
@@ -125,6 +137,7 @@ protected:
     unsigned upx_dt_init;  // DT_INIT, DT_PREINIT_ARRAY, DT_INIT_ARRAY
     static unsigned const DT_NUM = 34;  // elf.h
     unsigned dt_table[DT_NUM];  // 1+ index of DT_xxxxx in PT_DYNAMIC
+    upx_uint64_t dt_dup_mask;  // bit DT_xxxxx: tag occurs more than once
 
     MemBuffer mb_shstrtab;   // via ElfXX_Shdr
     char const *shstrtab;
@@ -145,6 +158,7 @@ public:
 protected:
     virtual void PackLinuxElf32help1(InputFile *f);
     virtual int checkEhdr(Elf32_Ehdr const *ehdr) const;
+    virtual unsigned getCompressedExtents(FileExtent *x, unsigned max) const override;
     virtual bool canPackOSABI(Elf32_Ehdr const *);
     virtual tribool canPack() override;
     virtual tribool canUnpack() override; // bool, except -1: format known, but not packed
@@ -324,6 +338,7 @@ public:
 protected:
     virtual void PackLinuxElf64help1(InputFile *f);
     virtual int checkEhdr(Elf64_Ehdr const *ehdr) const;
+    virtual unsigned getCompressedExtents(FileExtent *x, unsigned max) const override;
     virtual tribool canPack() override;
     virtual tribool canUnpack() override; // bool, except -1: format known, but not packed
 
@@ -337,7 +352,12 @@ protected:
     virtual off_t pack3(OutputFile *, Filter &) override;  // append loader
     virtual void pack4(OutputFile *, Filter &) override;  // append pack header
     virtual unsigned forward_Shdrs(OutputFile *fo, Elf64_Ehdr *ehdro);
+    virtual void collect_symbol_Shdrs();  // --preserve-symbols
+    virtual bool canPreserveSymbols() const override { return true; }
+    virtual void write_symbol_Shdrs(OutputFile *fo, Elf64_Ehdr *ehdro);
     virtual void unpack(OutputFile *fo) override;
+    virtual bool canUnpackRange() const override { return true; }
+    virtual void unpack_range(OutputFile *fo, Elf64_Phdr const *phdr, unsigned u_phnum);
     virtual void un_asl_dynsym(unsigned orig_file_size, OutputFile *);
     virtual void un_shlib_1(
         OutputFile *const fo,
@@ -455,6 +475,12 @@ protected:
 
     cprElfShdr3 shdrout;
 
+    // --preserve-symbols: copy of the input Shdr table, and the contents
+    // of the sections which keep their bytes
+    MemBuffer mb_sym_shdrs;
+    MemBuffer mb_sym_data;
+    unsigned sym_shnum;  // 0 ==> not active
+
     static void compileTimeAssertions() {
         COMPILE_TIME_ASSERT(sizeof(cprElfHdr1) == 64 + 1*56 + 12)
         COMPILE_TIME_ASSERT(sizeof(cprElfHdr2) == 64 + 2*56 + 12)
@@ -473,7 +499,7 @@ class PackLinuxElf32Be : public PackLinuxElf32
 protected:
     PackLinuxElf32Be(InputFile *f) : super(f) {
         bele = &N_BELE_RTP::be_policy;
-        PackLinuxElf32help1(f);
+        PackLinuxElf32help1(nullptr);  // Ehdr only; canPack() and canUnpack() read the file
     }
 };
 
@@ -483,7 +509,7 @@ class PackLinuxElf32Le : public PackLinuxElf32
 protected:
     PackLinuxElf32Le(InputFile *f) : super(f) {
         bele = &N_BELE_RTP::le_policy;
-        PackLinuxElf32help1(f);
+        PackLinuxElf32help1(nullptr);  // Ehdr only; canPack() and canUnpack() read the file
     }
 };
 
@@ -495,7 +521,7 @@ protected:
         lg2_page=16;
         page_size=1u<<lg2_page;
         bele = &N_BELE_RTP::le_policy;
-        PackLinuxElf64help1(f);
+        PackLinuxElf64help1(nullptr);  // Ehdr only; canPack() and canUnpack() read the file
     }
 };
 
@@ -507,7 +533,7 @@ protected:
         lg2_page=16;
         page_size=1u<<lg2_page;
         bele = &N_BELE_RTP::be_policy;
-        PackLinuxElf64help1(f);
+        PackLinuxElf64help1(nullptr);  // Ehdr only; canPack() and canUnpack() read the file
     }
 };
 
@@ -47,7 +47,7 @@
 **************************************************************************/
 
 PackUnix::PackUnix(InputFile *f) :
-    super(f), exetype(0), blocksize(0), overlay_offset(0), lsize(0),
+    super(f), base_nblocks(0), base_nreused(0), exetype(0), blocksize(0), overlay_offset(0), lsize(0),
     methods_used(0), szb_info(sizeof(b_info))
 {
     COMPILE_TIME_ASSERT(sizeof(Elf32_Ehdr) == 52)
@@ -302,6 +302,8 @@ void PackUnix::pack(OutputFile *fo)
     ibuf.alloc(blocksize);
     obuf.allocForCompression(blocksize);
 
+    readBaseBlocks();  // --base=FILE
+
     fi->seek(0, SEEK_SET);
     pack1(fo, ft);  // generate Elf header, etc.
 
@@ -321,6 +323,8 @@ void PackUnix::pack(OutputFile *fo)
         set_le32(&hdr.sz_cpr, UPX_MAGIC_LE32);
         fo->write(&hdr, sizeof(hdr));
     }
+    if (base_nblocks && opt->verbose >= 2)
+        infoWarning("--base: %u of %u blocks re-used", base_nreused, base_nblocks);
 
     pack3(fo, ft);  // append loader
 
@@ -332,6 +336,199 @@ void PackUnix::pack(OutputFile *fo)
 }
 
 
+/*************************************************************************
+// --base=FILE: re-use compressed blocks from a previous packing.
+// b_info has no per-block checksum, so index the old blocks by
+// adler32 of their unfiltered contents; every candidate is verified
+// by decompression and memcmp() before its bytes are copied.
+//
+// Cost: readBaseBlocks() reads all of the base file into memory and
+// decompresses every block once to build the index, i.e. about the time
+// and memory of "upx -d" on the base file; each re-used block is
+// decompressed once more for the verification.
+**************************************************************************/
+
+int __acc_cdecl_qsort PackUnix::compare_BaseBlock(const void *a, const void *b) {
+    const BaseBlock *x = (const BaseBlock *) a;
+    const BaseBlock *y = (const BaseBlock *) b;
+    if (x->u_adler != y->u_adler)
+        return x->u_adler < y->u_adler ? -1 : 1;
+    if (x->sz_unc != y->sz_unc)
+        return x->sz_unc < y->sz_unc ? -1 : 1;
+    return x->b_off < y->b_off ? -1 : (x->b_off > y->b_off);
+}
+
+void PackUnix::readBaseBlocks()
+{
+    base_nblocks = 0;
+    base_nreused = 0;
+    char const *const bname = opt->o_unix.base_file;
+    if (!bname || !bname[0])
+        return;
+
+    InputFile bfi;
+    bfi.open(bname, O_RDONLY | O_BINARY);
+    upx_off_t const bsize = bfi.st_size();
+    if (bsize <= (upx_off_t)(sizeof(l_info) + sizeof(p_info)) || !mem_size_valid_bytes(bsize)) {
+        printWarn(bname, "--base: file too small or too large; ignored");
+        return;
+    }
+    unsigned const ubsize = (unsigned) bsize;
+    base_image.alloc(ubsize);
+    bfi.readx(base_image, ubsize);
+    bfi.closex();
+
+    // Locate the PackHeader and overlay_offset of the base file, exactly as
+    // canUnpack() would; but without disturbing our own packing state.
+    PackHeader const saved_ph = ph;
+    unsigned const saved_overlay_offset = overlay_offset;
+    unsigned b_off = 0;
+    try {
+        int const small = 32 + sizeof(overlay_offset);
+        int bufsize = 2*4096 + 2*small +1;
+        if ((unsigned)bufsize > ubsize)
+            bufsize = ubsize;
+        MemBuffer buf(bufsize);
+        memcpy(buf, base_image + (ubsize - bufsize), bufsize);
+        if (find_overlay_offset(buf))
+            b_off = overlay_offset;
+    }
+    catch (const Exception &) {
+        b_off = 0;
+    }
+    ph = saved_ph;
+    overlay_offset = saved_overlay_offset;
+
+    unsigned base_blocksize = 0;
+    if (sizeof(l_info) <= b_off && (b_off + sizeof(p_info)) < ubsize) {
+        l_info const *const lp = (l_info const *)raw_index_bytes(base_image,
+            b_off - sizeof(l_info), sizeof(l_info));
+        p_info const *const pp = (p_info const *)raw_index_bytes(base_image,
+            b_off, sizeof(p_info));
+        if (UPX_MAGIC_LE32 == get_le32(&lp->l_magic))
+            base_blocksize = get_te32(&pp->p_blocksize);
+        b_off += sizeof(p_info);
+    }
+    if (!base_blocksize || !mem_size_valid(1, base_blocksize, OVERHEAD)) {
+        printWarn(bname, "--base: not a packed file of this format; ignored");
+        base_image.dealloc();
+        return;
+    }
+
+    // Walk the b_info chain until the first implausible header.
+    // Literal (stored) blocks are not worth indexing.
+    unsigned n = 0;
+    for (unsigned pass = 0; pass < 2; ++pass) {
+        BaseBlock *const bb = (BaseBlock *)(pass ? base_index.getVoidPtr() : nullptr);
+        n = 0;
+        for (unsigned off = b_off; (off + sizeof(b_info)) <= ubsize; ) {
+            b_info const *const h = (b_info const *)raw_index_bytes(base_image, off, sizeof(b_info));
+            unsigned const sz_unc = get_te32(&h->sz_unc);
+            unsigned const sz_cpr = get_te32(&h->sz_cpr);
+            if (!sz_unc || !sz_cpr || sz_cpr > sz_unc || sz_unc > base_blocksize
+            ||  (ubsize - off - sizeof(b_info)) < sz_cpr)
+                break;
+            if (sz_cpr < sz_unc) {
+                if (!isValidCompressionMethod(h->b_method))
+                    break;
+                if (bb) {
+                    if (!unpackBaseBlock(off, base_ubuf))
+                        break;
+                    bb[n].u_adler = upx_adler32(base_ubuf, sz_unc);
+                    bb[n].sz_unc = sz_unc;
+                    bb[n].b_off = off;
+                }
+                ++n;
+            }
+            off += sizeof(b_info) + sz_cpr;
+        }
+        if (!n)
+            break;
+        if (!pass) {
+            base_index.alloc(mem_size(sizeof(BaseBlock), n));
+            base_ubuf.alloc(base_blocksize);
+        }
+    }
+    if (!n) {
+        printWarn(bname, "--base: no compressed blocks found; ignored");
+        base_image.dealloc();
+        return;
+    }
+    upx_qsort(base_index.getVoidPtr(), n, sizeof(BaseBlock), compare_BaseBlock);
+    base_nblocks = n;
+    if (opt->verbose >= 2)
+        infoWarning("--base: %u blocks indexed from %s", n, bname);
+}
+
+// Decompress and unfilter the block whose b_info is at base_image[b_off].
+bool PackUnix::unpackBaseBlock(unsigned b_off, byte *out) const
+{
+    b_info const *const h = (b_info const *)raw_index_bytes(base_image, b_off, sizeof(b_info));
+    unsigned const sz_cpr = get_te32(&h->sz_cpr);
+    unsigned sz_unc = get_te32(&h->sz_unc);
+    unsigned const want = sz_unc;
+    byte const *const cdata = raw_index_bytes(base_image, b_off + sizeof(b_info), sz_cpr);
+    int r = UPX_E_ERROR;
+    try {
+        r = upx_decompress(cdata, sz_cpr, out, &sz_unc, h->b_method, nullptr);
+    }
+    catch (const Exception &) {
+        return false;
+    }
+    if (r != UPX_E_OK || sz_unc != want)
+        return false;
+    if (h->b_ftid) {
+        Filter ft(ph.level);
+        ft.init(h->b_ftid, 0);
+        ft.cto = h->b_cto8;
+        ft.unfilter(out, sz_unc);
+    }
+    return true;
+}
+
+// If the 'len' bytes in ibuf match a compressed block of the base file
+// which the current loader can decompress, then append that block verbatim.
+bool PackUnix::reuseBaseBlock(OutputFile *fo, Filter const *ft, unsigned len, unsigned b_extra)
+{
+    BaseBlock const *const bb = (BaseBlock const *) base_index.getVoidPtr();
+    unsigned const u_adler = upx_adler32(ibuf, len);
+    unsigned lo = 0, hi = base_nblocks;
+    while (lo < hi) { // lower_bound of (u_adler, len)
+        unsigned const mid = lo + (hi - lo) / 2;
+        if (bb[mid].u_adler < u_adler
+        ||  (bb[mid].u_adler == u_adler && bb[mid].sz_unc < len))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    for (; lo < base_nblocks && bb[lo].u_adler == u_adler && bb[lo].sz_unc == len; ++lo) {
+        unsigned const b_off = bb[lo].b_off;
+        b_info const *const h = (b_info const *)raw_index_bytes(base_image, b_off, sizeof(b_info));
+        if (h->b_method != (unsigned char) ph.method)
+            continue;  // loader might lack the de-compressor
+        if (h->b_ftid && !(ft && h->b_ftid == ft->id))
+            continue;  // loader might lack the un-filter
+        if (!unpackBaseBlock(b_off, base_ubuf) || memcmp(base_ubuf, ibuf, len))
+            continue;  // adler32 collision
+
+        unsigned const sz_cpr = get_te32(&h->sz_cpr);
+        byte const *const cdata = raw_index_bytes(base_image, b_off + sizeof(b_info), sz_cpr);
+        b_info tmp;
+        memcpy(&tmp, h, sizeof(tmp));
+        tmp.b_extra = b_extra;
+        fo->write(&tmp, sizeof(tmp));
+        fo->write(cdata, sz_cpr);
+        ph.u_adler = upx_adler32(ibuf, len, ph.u_adler);
+        ph.c_adler = upx_adler32(cdata, sz_cpr, ph.c_adler);
+        total_out += sizeof(tmp) + sz_cpr;
+        total_in += len;
+        b_len += sizeof(b_info);
+        ++base_nreused;
+        return true;
+    }
+    return false;
+}
+
 void PackUnix::packExtent(
     const Extent &x,
     Filter *ft,
@@ -350,14 +547,31 @@ void PackUnix::packExtent(
         int l = fi->readx(hdr_ibuf, hdr_u_len);
         (void)l;
     }
+    unsigned const x_blocksize = opt->o_unix.auto_blocksize ? chooseBlocksize(x) : blocksize;
     fi->seek(x.offset, SEEK_SET);
+    fi->adviseWillNeed(x.offset, x.size);
+    bool method_chosen = false;  // --base: re-use needs a settled method and filter
     for (off_t rest = x.size; 0 != rest; ) {
         int const filter_strategy = ft ? getStrategy(*ft) : 0;
-        int l = fi->readx(ibuf, UPX_MIN(rest, (off_t)blocksize));
+        int l = fi->readx(ibuf, UPX_MIN(rest, (off_t)x_blocksize));
         if (l == 0) {
             break;
         }
+        if (opt->o_unix.cdc_blocks) {
+            // Cut where the content says so, not at a fixed offset, so that
+            // an insertion or deletion moves only the neighboring boundaries.
+            // blocksize remains the maximum; the average is blocksize/4.
+            int const cut = cdc_cut(ibuf, l, x_blocksize / 16, x_blocksize / 4);
+            if (cut < l) {
+                fi->seek(cut - l, SEEK_CUR);
+                l = cut;
+            }
+        }
         rest -= l;
+        if (base_nblocks && method_chosen && !hdr_u_len
+        &&  reuseBaseBlock(fo, ft, l, b_extra)) {
+            continue;
+        }
 
         // Note: compression for a block can fail if the
         //       file is e.g. blocksize + 1 bytes long
@@ -406,17 +620,10 @@ void PackUnix::packExtent(
         // write block sizes
         b_info tmp;
         if (hdr_u_len) {
-            unsigned hdr_c_len = 0;
-            MemBuffer hdr_obuf;
-            hdr_obuf.allocForCompression(hdr_u_len);
-            int r = upx_compress(hdr_ibuf, hdr_u_len, hdr_obuf, &hdr_c_len,
-                /* &progress callback */ nullptr,
-                ph_forced_method(ph.method), 10,
-                /* &config_t */ nullptr, /* &result_t */ nullptr);
-            if (r != UPX_E_OK)
-                throwInternalError("header compression failed");
-            if (hdr_c_len >= hdr_u_len)
-                throwInternalError("header compression size increase");
+            // usually already compressed by compressWithFilters()
+            const byte *hdr_obuf = nullptr;
+            unsigned const hdr_c_len = compressHeader(hdr_ibuf, hdr_u_len,
+                ph_forced_method(ph.method), &hdr_obuf);
             ph.saved_u_adler = upx_adler32(hdr_ibuf, hdr_u_len, init_u_adler);
             ph.saved_c_adler = upx_adler32(hdr_obuf, hdr_c_len, init_c_adler);
             ph.u_adler = upx_adler32(ibuf, ph.u_len, ph.saved_u_adler);
@@ -466,7 +673,46 @@ void PackUnix::packExtent(
         }
 
         total_in += ph.u_len;
+        method_chosen = true;
+    }
+}
+
+// --blocksize=auto
+// One block per extent gives the best ratio and the fewest b_info.
+// But if samples show both compressible and incompressible stretches,
+// then smaller blocks let each stretch be filtered or stored on its own;
+// a stored block de-compresses at memcpy speed.  --optimize-for decides
+// how much incompressible data makes that worth the lost history.
+// The result never exceeds this->blocksize (p_info.p_blocksize), so the
+// limits of the de-compressor and of unpack are unchanged.
+unsigned PackUnix::chooseBlocksize(const Extent &x)
+{
+    enum { SAMPLES = 16, SAMPLE_LEN = 4096, GRANULE = 64 * 1024 };
+    unsigned const whole = (unsigned)UPX_MIN(x.size, (upx_off_t)blocksize);
+    if (x.size < 4 * GRANULE)
+        return whole;
+    byte sample[SAMPLE_LEN];
+    upx_off_t const stride = x.size / SAMPLES;
+    unsigned n_stored = 0;  // samples at 7.5 bits per byte or more
+    for (unsigned k = 0; k < SAMPLES; ++k) {
+        fi->seek(x.offset + k * stride + (stride - SAMPLE_LEN) / 2, SEEK_SET);
+        fi->readx(sample, SAMPLE_LEN);
+        if (byte_entropy(sample, SAMPLE_LEN) >= 7 * 256 + 128)
+            ++n_stored;
+    }
+    unsigned const min_stored = (opt->optimize_for == opt->OPTIMIZE_STARTUP) ? 1
+        : (opt->optimize_for == opt->OPTIMIZE_BALANCED) ? SAMPLES / 8 : SAMPLES / 4;
+    unsigned bs = whole;
+    if (min_stored <= n_stored && n_stored < SAMPLES) {
+        // about one block per sample
+        upx_off_t const g = (stride + GRANULE - 1) & ~(upx_off_t)(GRANULE - 1);
+        bs = (unsigned)UPX_MIN(g, (upx_off_t)whole);
     }
+    if (opt->verbose >= 3)
+        info("--blocksize=auto: %#llx bytes at %#llx: %u stored of %u samples, blocksize %#x",
+            (unsigned long long)x.size, (unsigned long long)x.offset, n_stored,
+            (unsigned)SAMPLES, bs);
+    return bs;
 }
 
 // Consumes b_info header block and sz_cpr data block from input file 'fi'.
@@ -73,6 +73,7 @@ protected:
     virtual void writePackHeader(OutputFile *fo);
 
     virtual bool checkCompressionRatio(unsigned, unsigned) const override;
+    virtual bool canMemoLoaderSize() const override { return true; }
 
 protected:
     struct Extent {
@@ -83,6 +84,8 @@ protected:
         Filter *, OutputFile *,
         unsigned hdr_len = 0, unsigned b_extra = 0 ,
         bool inhibit_compression_check = false);
+    // --blocksize=auto: the block size for packExtent(x)
+    unsigned chooseBlocksize(const Extent &x);
     virtual unsigned unpackExtent(unsigned wanted, OutputFile *fo,
         unsigned &c_adler, unsigned &u_adler,
         bool first_PF_X,
@@ -90,6 +93,22 @@ protected:
         );
     unsigned total_in, total_out;  // unpack
 
+    // --base=FILE: compressed blocks of a previous packing, for re-use
+    struct BaseBlock {
+        unsigned u_adler;  // adler32 of unfiltered uncompressed data
+        unsigned sz_unc;
+        unsigned b_off;    // offset of b_info in base_image
+    };
+    static int __acc_cdecl_qsort compare_BaseBlock(const void *, const void *);
+    virtual void readBaseBlocks();
+    bool unpackBaseBlock(unsigned b_off, byte *out) const;
+    bool reuseBaseBlock(OutputFile *fo, Filter const *ft, unsigned len, unsigned b_extra);
+    MemBuffer base_image;
+    MemBuffer base_index;  // BaseBlock[base_nblocks], sorted by (u_adler, sz_unc)
+    MemBuffer base_ubuf;
+    unsigned base_nblocks;
+    unsigned base_nreused;  // blocks copied by reuseBaseBlock()
+
     int exetype;  // 0: unknown; 1: ELF; 2: pre-ELF; -1: /bin/sh; -2: Java
     unsigned blocksize;
     unsigned progid;              // program id
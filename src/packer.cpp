@@ -25,12 +25,15 @@
    <markus@oberhumer.com>               <ezerotven+github@gmail.com>
  */
 
+#include "util/system_headers.h"
+#include <chrono>
 #include "conf.h"
 #include "file.h"
 #include "packer.h"
 #include "filter.h"
 #include "linker.h"
 #include "ui.h"
+#include "util/work_sched.h"
 
 /*************************************************************************
 //
@@ -86,17 +89,33 @@ void Packer::assertPacker() const {
 #endif
 }
 
+// --time-budget: milliseconds of a monotonic clock
+static upx_uint64_t time_budget_now_ms() {
+    using namespace std::chrono;
+    return (upx_uint64_t) duration_cast<milliseconds>(steady_clock::now().time_since_epoch())
+        .count();
+}
+
 /*************************************************************************
 // public entries called from class PackMaster
 **************************************************************************/
 
 void Packer::doPack(OutputFile *fo) {
+    if (opt->o_unix.preserve_symbols && !canPreserveSymbols())
+        throwCantPack("--preserve-symbols is not supported for this format");
     uip->uiPackStart(fo);
+    if (opt->time_budget)
+        time_budget_deadline = time_budget_now_ms() + 1000ull * opt->time_budget;
     pack(fo);
+    if (time_budget_deadline)
+        info("Time budget: %u compression variants tried, %u skipped", time_budget_tried,
+             time_budget_skipped);
     uip->uiPackEnd(fo);
 }
 
 void Packer::doUnpack(OutputFile *fo) {
+    if (opt->o_unix.extract_len && !canUnpackRange())
+        throwCantUnpack("--extract-range is not supported for this format");
     uip->uiUnpackStart(fo);
     unpack(fo);
     uip->uiUnpackEnd(fo);
@@ -120,6 +139,13 @@ void Packer::doFileInfo() {
     uip->uiFileInfoEnd();
 }
 
+void Packer::doEstimate() {
+    uip->uiEstimateStart();
+    PackEstimate e;
+    estimate(&e);
+    uip->uiEstimateEnd(e);
+}
+
 /*************************************************************************
 // default actions
 **************************************************************************/
@@ -151,8 +177,53 @@ bool Packer::testUnpackFormat(int format) const {
 // compress - wrap call to low-level upx_compress()
 **************************************************************************/
 
+// a compression that was run in parallel by compressWithFilters()
+struct Packer::CompressTrial {
+    int method = 0;
+    upx_compress_config_t cconf;
+    MemBuffer obuf;
+    unsigned c_len = 0;
+    int r = UPX_E_ERROR;
+    upx_compress_result_t cresult;
+    bool skipped = false; // --time-budget expired before the trial started
+};
+
+void Packer::getCompressConfig(upx_compress_config_t *cconf,
+                               const upx_compress_config_t *cconf_parm, int method) const {
+    cconf->reset();
+    if (cconf_parm)
+        *cconf = *cconf_parm;
+    // cconf options
+    if (M_IS_NRV2B(method) || M_IS_NRV2D(method) || M_IS_NRV2E(method)) {
+        if (opt->crp.crp_ucl.c_flags != -1)
+            cconf->conf_ucl.c_flags = opt->crp.crp_ucl.c_flags;
+        if (opt->crp.crp_ucl.p_level != -1)
+            cconf->conf_ucl.p_level = opt->crp.crp_ucl.p_level;
+        if (opt->crp.crp_ucl.h_level != -1)
+            cconf->conf_ucl.h_level = opt->crp.crp_ucl.h_level;
+        if (opt->crp.crp_ucl.max_offset != UINT_MAX &&
+            opt->crp.crp_ucl.max_offset < cconf->conf_ucl.max_offset)
+            cconf->conf_ucl.max_offset = opt->crp.crp_ucl.max_offset;
+        if (opt->crp.crp_ucl.max_match != UINT_MAX &&
+            opt->crp.crp_ucl.max_match < cconf->conf_ucl.max_match)
+            cconf->conf_ucl.max_match = opt->crp.crp_ucl.max_match;
+    }
+    if (M_IS_LZMA(method)) {
+        upx::oassign(cconf->conf_lzma.pos_bits, opt->crp.crp_lzma.pos_bits);
+        upx::oassign(cconf->conf_lzma.lit_pos_bits, opt->crp.crp_lzma.lit_pos_bits);
+        upx::oassign(cconf->conf_lzma.lit_context_bits, opt->crp.crp_lzma.lit_context_bits);
+        upx::oassign(cconf->conf_lzma.dict_size, opt->crp.crp_lzma.dict_size);
+        upx::oassign(cconf->conf_lzma.num_fast_bytes, opt->crp.crp_lzma.num_fast_bytes);
+    }
+    if (M_IS_DEFLATE(method)) {
+        upx::oassign(cconf->conf_zlib.mem_level, opt->crp.crp_zlib.mem_level);
+        upx::oassign(cconf->conf_zlib.window_bits, opt->crp.crp_zlib.window_bits);
+        upx::oassign(cconf->conf_zlib.strategy, opt->crp.crp_zlib.strategy);
+    }
+}
+
 bool Packer::compress(SPAN_P(byte) i_ptr, unsigned i_len, SPAN_P(byte) o_ptr,
-                      const upx_compress_config_t *cconf_parm) {
+                      const upx_compress_config_t *cconf_parm, const CompressTrial *trial) {
     ph.u_len = i_len;
     ph.c_len = 0;
     assert(ph.level >= 1);
@@ -168,42 +239,14 @@ bool Packer::compress(SPAN_P(byte) i_ptr, unsigned i_len, SPAN_P(byte) o_ptr,
     ph.u_adler = upx_adler32(raw_bytes(i_ptr, ph.u_len), ph.u_len, ph.u_adler);
 
     // set compression parameters
-    upx_compress_config_t cconf;
-    cconf.reset();
-    if (cconf_parm)
-        cconf = *cconf_parm;
-    // cconf options
     int method = ph_forced_method(ph.method);
-    if (M_IS_NRV2B(method) || M_IS_NRV2D(method) || M_IS_NRV2E(method)) {
-        if (opt->crp.crp_ucl.c_flags != -1)
-            cconf.conf_ucl.c_flags = opt->crp.crp_ucl.c_flags;
-        if (opt->crp.crp_ucl.p_level != -1)
-            cconf.conf_ucl.p_level = opt->crp.crp_ucl.p_level;
-        if (opt->crp.crp_ucl.h_level != -1)
-            cconf.conf_ucl.h_level = opt->crp.crp_ucl.h_level;
-        if (opt->crp.crp_ucl.max_offset != UINT_MAX &&
-            opt->crp.crp_ucl.max_offset < cconf.conf_ucl.max_offset)
-            cconf.conf_ucl.max_offset = opt->crp.crp_ucl.max_offset;
-        if (opt->crp.crp_ucl.max_match != UINT_MAX &&
-            opt->crp.crp_ucl.max_match < cconf.conf_ucl.max_match)
-            cconf.conf_ucl.max_match = opt->crp.crp_ucl.max_match;
+    upx_compress_config_t cconf;
+    getCompressConfig(&cconf, cconf_parm, method);
 #if (WITH_NRV)
-        if ((ph.level >= 7 || (ph.level >= 4 && ph.u_len >= 512 * 1024)) && !opt->prefer_ucl)
-            step = 0;
+    if ((M_IS_NRV2B(method) || M_IS_NRV2D(method) || M_IS_NRV2E(method)) &&
+        (ph.level >= 7 || (ph.level >= 4 && ph.u_len >= 512 * 1024)) && !opt->prefer_ucl)
+        step = 0;
 #endif
-    }
-    if (M_IS_LZMA(method)) {
-        upx::oassign(cconf.conf_lzma.pos_bits, opt->crp.crp_lzma.pos_bits);
-        upx::oassign(cconf.conf_lzma.lit_pos_bits, opt->crp.crp_lzma.lit_pos_bits);
-        upx::oassign(cconf.conf_lzma.lit_context_bits, opt->crp.crp_lzma.lit_context_bits);
-        upx::oassign(cconf.conf_lzma.dict_size, opt->crp.crp_lzma.dict_size);
-        upx::oassign(cconf.conf_lzma.num_fast_bytes, opt->crp.crp_lzma.num_fast_bytes);
-    }
-    if (M_IS_DEFLATE(method)) {
-        upx::oassign(cconf.conf_zlib.mem_level, opt->crp.crp_zlib.mem_level);
-        upx::oassign(cconf.conf_zlib.window_bits, opt->crp.crp_zlib.window_bits);
-        upx::oassign(cconf.conf_zlib.strategy, opt->crp.crp_zlib.strategy);
-    }
     if (uip->ui_pass >= 0)
         uip->ui_pass++;
     uip->startCallback(ph.u_len, step, uip->ui_pass, uip->ui_total_passes);
@@ -212,7 +255,16 @@ bool Packer::compress(SPAN_P(byte) i_ptr, unsigned i_len, SPAN_P(byte) o_ptr,
     // OutputFile::dump("data.raw", in, ph.u_len);
 
     // compress
-    int r = upx_compress(raw_bytes(i_ptr, ph.u_len), ph.u_len, raw_bytes(o_ptr, 0), &ph.c_len,
+    int r;
+    if (trial != nullptr) {
+        assert(trial->method == method);
+        r = trial->r;
+        ph.c_len = trial->c_len;
+        ph.compress_result = trial->cresult;
+        if (r == UPX_E_OK && raw_bytes(o_ptr, 0) != trial->obuf.getVoidPtr())
+            memcpy(raw_bytes(o_ptr, ph.c_len), trial->obuf.getVoidPtr(), ph.c_len);
+    } else
+        r = upx_compress(raw_bytes(i_ptr, ph.u_len), ph.u_len, raw_bytes(o_ptr, 0), &ph.c_len,
                          uip->getCallback(), method, ph.level, &cconf, &ph.compress_result);
 
     // uip->finalCallback(ph.u_len, ph.c_len);
@@ -452,6 +504,11 @@ void Packer::copyOverlay(OutputFile *fo, unsigned overlay, MemBuffer &buf, bool
     if (do_seek)
         fi->seek(-(upx_off_t) overlay, SEEK_END);
 
+    // try a kernel-side copy first; overlays can be huge
+    overlay -= (unsigned) fo->copyFrom(fi, overlay);
+    if (overlay == 0)
+        return;
+
     // get buffer size, align to improve i/o speed
     unsigned buf_size = buf.getSize();
     if (buf_size > 65536)
@@ -1038,6 +1095,8 @@ void Packer::compressWithFilters(byte *i_ptr,
     best_ph.overlap_overhead = 0;
     unsigned best_ph_lsize = 0;
     unsigned best_hdr_c_len = 0;
+    unsigned best_penalty = 0; // --optimize-for
+    bool best_ph_valid = false;
 
     // preconditions
     assert(orig_ph.filter == 0);
@@ -1076,95 +1135,136 @@ void Packer::compressWithFilters(byte *i_ptr,
     byte *o_tmp = o_ptr;
     MemBuffer o_tmp_buf;
 
-    // compress using all methods/filters
+    // headers are never filtered; compress them once per method
+    unsigned hdr_c_lens[MAX_METHODS] = {};
+    if (hdr_ptr != nullptr && hdr_len)
+        for (int mm = 0; mm < nmethods; mm++)
+            hdr_c_lens[mm] = compressHeader(hdr_ptr, hdr_len, methods[mm]);
+
+    // --threads: the methods for one filter are compressed in parallel,
+    //   getConcurrency() at a time, and then judged one after the other just
+    //   like before; so there are at most nslots live output buffers
+    WorkScheduler &sched = WorkScheduler::get();
+    const bool parallel = nmethods >= 2 && sched.getConcurrency() >= 2;
+    const int nslots = parallel ? UPX_MIN(nmethods, (int) sched.getConcurrency()) : 0;
+    CompressTrial trials[MAX_METHODS];
+
+    // compress using all filters/methods
+    //   --time-budget: the first successful variant is always finished, so
+    //   there is a valid result; after the deadline the rest are skipped
     int nfilters_success_total = 0;
-    for (int mm = 0; mm < nmethods; mm++) // for all methods
+    int best_mm = -1;
+    for (int ff = 0; ff < nfilters; ff++) // for all filters
     {
-        NO_printf("\nmethod %d (%d of %d)\n", methods[mm], 1 + mm, nmethods);
-        assert(isValidCompressionMethod(methods[mm]));
-        unsigned hdr_c_len = 0;
-        if (hdr_ptr != nullptr && hdr_len) {
-            if (nfilters_success_total != 0 && o_tmp == o_ptr) {
-                // do not overwrite o_ptr
-                o_tmp_buf.allocForCompression(UPX_MAX(hdr_len, i_len));
-                o_tmp = o_tmp_buf;
+        if (nfilters_success_total != 0 && isTimeBudgetExpired()) {
+            time_budget_skipped += (nfilters - ff) * nmethods;
+            break;
+        }
+        assert(isValidFilter(filters[ff]));
+        // get fresh filter
+        Filter ft = orig_ft;
+        ft.init(filters[ff], orig_ft.addvalue);
+        // filter
+        optimizeFilter(&ft, f_ptr, f_len);
+        bool success = ft.filter(f_ptr, f_len);
+        if (ft.id != 0 && ft.calls == 0) {
+            // filter did not do anything - no need to call ft.unfilter()
+            success = false;
+        }
+        if (!success) {
+            // filter failed or was useless
+            if (filter_strategy >= 0) {
+                // adjust ui passes
+                if (uip->ui_pass >= 0)
+                    uip->ui_pass += nmethods;
             }
-            int r = upx_compress(hdr_ptr, hdr_len, o_tmp, &hdr_c_len, nullptr, methods[mm], 10,
-                                 nullptr, nullptr);
-            if (r != UPX_E_OK)
-                throwInternalError("header compression failed");
-            if (hdr_c_len >= hdr_len)
-                throwInternalError("header compression size increase");
-            MemBuffer mb_uncLoader(10 + hdr_len);
-            unsigned unc_len = hdr_len;
-            r = upx_decompress(o_tmp, hdr_c_len, (unsigned char *) mb_uncLoader, &unc_len,
-                               methods[mm], nullptr);
-            if (r != UPX_E_OK)
-                throwInternalError("header compression failed");
+            continue;
         }
-        int nfilters_success_mm = 0;
-        for (int ff = 0; ff < nfilters; ff++) // for all filters
+        // filter success
+        NO_printf("\nfilter: id 0x%02x size %6d, calls %5d/%5d/%3d/%5d/%5d, cto 0x%02x\n", ft.id,
+                  ft.buf_len, ft.calls, ft.noncalls, ft.wrongcalls, ft.firstcall, ft.lastcall,
+                  ft.cto);
+        for (int mm = 0; mm < nmethods; mm++) // for all methods
         {
-            assert(isValidFilter(filters[ff]));
+            if (parallel && mm % nslots == 0) {
+                // --time-budget: checked before each trial is submitted, and again
+                //   when it starts, as trials may wait in the queue for a while;
+                //   the first trial of the first filter always runs
+                WorkGroup group(sched);
+                for (int m = mm; m < nmethods && m < mm + nslots; m++) {
+                    CompressTrial &t = trials[m - mm];
+                    const bool may_skip = nfilters_success_total != 0 || m != 0;
+                    t.skipped = may_skip && isTimeBudgetExpired();
+                    if (t.skipped)
+                        continue;
+                    t.method = ph_forced_method(methods[m]);
+                    getCompressConfig(&t.cconf, cconf, t.method);
+                    if (t.obuf.getSize() == 0)
+                        t.obuf.allocForCompression(i_len);
+                    const int level = orig_ph.level;
+                    group.run([this, &t, i_ptr, i_len, level, may_skip]() {
+                        t.skipped = may_skip && isTimeBudgetExpired();
+                        if (t.skipped)
+                            return;
+                        t.c_len = 0;
+                        t.r = upx_compress(i_ptr, i_len, (upx_bytep) t.obuf.getVoidPtr(),
+                                           &t.c_len, nullptr, t.method, level, &t.cconf,
+                                           &t.cresult);
+                    });
+                }
+                group.wait();
+            }
+            if (!parallel && nfilters_success_total != 0 && isTimeBudgetExpired()) {
+                time_budget_skipped += nmethods - mm;
+                break;
+            }
+            if (parallel && trials[mm % nslots].skipped) {
+                time_budget_skipped += 1;
+                continue;
+            }
+            NO_printf("\nmethod %d (%d of %d)\n", methods[mm], 1 + mm, nmethods);
+            assert(isValidCompressionMethod(methods[mm]));
+            const unsigned hdr_c_len = hdr_c_lens[mm];
             // get fresh packheader
             ph = orig_ph;
             ph.method = methods[mm];
             ph.filter = filters[ff];
             ph.overlap_overhead = 0;
-            // get fresh filter
-            Filter ft = orig_ft;
-            ft.init(ph.filter, orig_ft.addvalue);
-            // filter
-            optimizeFilter(&ft, f_ptr, f_len);
-            bool success = ft.filter(f_ptr, f_len);
-            if (ft.id != 0 && ft.calls == 0) {
-                // filter did not do anything - no need to call ft.unfilter()
-                success = false;
-            }
-            if (!success) {
-                // filter failed or was useless
-                if (filter_strategy >= 0) {
-                    // adjust ui passes
-                    if (uip->ui_pass >= 0)
-                        uip->ui_pass++;
-                }
-                continue;
-            }
-            // filter success
-            NO_printf("\nfilter: id 0x%02x size %6d, calls %5d/%5d/%3d/%5d/%5d, cto 0x%02x\n",
-                      ft.id, ft.buf_len, ft.calls, ft.noncalls, ft.wrongcalls, ft.firstcall,
-                      ft.lastcall, ft.cto);
             if (nfilters_success_total != 0 && o_tmp == o_ptr) {
                 o_tmp_buf.allocForCompression(i_len);
                 o_tmp = o_tmp_buf;
             }
             nfilters_success_total++;
-            nfilters_success_mm++;
+            time_budget_tried++;
             ph.filter_cto = ft.cto;
             ph.n_mru = ft.n_mru;
             // compress
-            if (compress(i_ptr, i_len, o_tmp, cconf)) {
+            if (compress(i_ptr, i_len, o_tmp, cconf, parallel ? &trials[mm % nslots] : nullptr)) {
                 unsigned lsize = 0;
+                // --optimize-for: add the estimated decompression time; the
+                // initial best_ph (not compressed at all) is compared by size only
+                const unsigned penalty = getDecompressionPenalty(ph.method, i_len);
+                const unsigned best_penalty_cmp = best_ph_valid ? best_penalty : penalty;
                 // findOverlapOperhead() might be slow; omit if already too big.
-                if (ph.c_len + lsize + hdr_c_len <=
-                    best_ph.c_len + best_ph_lsize + best_hdr_c_len) {
+                if (ph.c_len + lsize + hdr_c_len + penalty <=
+                    best_ph.c_len + best_ph_lsize + best_hdr_c_len + best_penalty_cmp) {
                     // get results
                     ph.overlap_overhead = findOverlapOverhead(o_tmp, i_ptr, overlap_range);
                     if (-4 < filter_strategy) {
-                        buildLoader(&ft);
-                        lsize = getLoaderSize();
+                        lsize = getTrialLoaderSize(&ft);
                         assert(lsize > 0);
                     }
                 }
-                NO_printf("\n%2d %02x: %d +%4d +%3d = %d  (best: %d +%4d +%3d = %d)\n", ph.method,
-                          ph.filter, ph.c_len, lsize, hdr_c_len, ph.c_len + lsize + hdr_c_len,
-                          best_ph.c_len, best_ph_lsize, best_hdr_c_len,
-                          best_ph.c_len + best_ph_lsize + best_hdr_c_len);
+                const unsigned total = ph.c_len + lsize + hdr_c_len + penalty;
+                const unsigned best_total =
+                    best_ph.c_len + best_ph_lsize + best_hdr_c_len + best_penalty_cmp;
+                NO_printf("\n%2d %02x: %d +%4d +%3d +%d = %d  (best: %d +%4d +%3d = %d)\n",
+                          ph.method, ph.filter, ph.c_len, lsize, hdr_c_len, penalty, total,
+                          best_ph.c_len, best_ph_lsize, best_hdr_c_len, best_total);
                 bool update = false;
-                if (ph.c_len + lsize + hdr_c_len < best_ph.c_len + best_ph_lsize + best_hdr_c_len)
+                if (total < best_total)
                     update = true;
-                else if (ph.c_len + lsize + hdr_c_len ==
-                         best_ph.c_len + best_ph_lsize + best_hdr_c_len) {
+                else if (total == best_total) {
                     // prefer smaller loaders
                     if (lsize + hdr_c_len < best_ph_lsize + best_hdr_c_len)
                         update = true;
@@ -1172,6 +1272,11 @@ void Packer::compressWithFilters(byte *i_ptr,
                         // prefer less overlap_overhead
                         if (ph.overlap_overhead < best_ph.overlap_overhead)
                             update = true;
+                        // a complete tie: the earlier method wins, as it
+                        // did when methods were the outer loop
+                        else if (ph.overlap_overhead == best_ph.overlap_overhead &&
+                                 best_ph_valid && mm < best_mm)
+                            update = true;
                     }
                 }
                 if (update) {
@@ -1183,15 +1288,17 @@ void Packer::compressWithFilters(byte *i_ptr,
                     best_ph = ph;
                     best_ph_lsize = lsize;
                     best_hdr_c_len = hdr_c_len;
+                    best_penalty = penalty;
+                    best_ph_valid = true;
                     best_ft = ft;
+                    best_mm = mm;
                 }
             }
-            // restore - unfilter with verify
-            ft.unfilter(f_ptr, f_len, true);
-            if (filter_strategy < 0)
-                break;
         }
-        assert(nfilters_success_mm > 0);
+        // restore - unfilter with verify
+        ft.unfilter(f_ptr, f_len, true);
+        if (filter_strategy < 0)
+            break;
     }
 
     // postconditions 1)
@@ -1221,6 +1328,85 @@ void Packer::compressWithFilters(byte *i_ptr,
     buildLoader(&best_ft);
 }
 
+bool Packer::isTimeBudgetExpired() const {
+    return time_budget_deadline != 0 && time_budget_now_ms() >= time_budget_deadline;
+}
+
+/*************************************************************************
+// compressWithFilters() needs the loader size of every improving trial;
+// running the linker for it each time is expensive.  The final
+// buildLoader(&best_ft) of compressWithFilters() is never memoized.
+**************************************************************************/
+
+unsigned Packer::getTrialLoaderSize(const Filter *ft) {
+    if (!canMemoLoaderSize()) {
+        buildLoader(ft);
+        return getLoaderSize();
+    }
+    for (unsigned i = 0; i < lsize_memo_n; i++) {
+        const LoaderSizeMemo &m = lsize_memo[i];
+        if (m.method == ph.method && m.filter == ft->id && m.n_mru == ft->n_mru)
+            return m.lsize;
+    }
+    buildLoader(ft);
+    unsigned const lsize = getLoaderSize();
+    if (lsize_memo_n < MAX_METHODS * MAX_FILTERS) {
+        LoaderSizeMemo &m = lsize_memo[lsize_memo_n++];
+        m.method = ph.method;
+        m.filter = ft->id;
+        m.n_mru = ft->n_mru;
+        m.lsize = lsize;
+    }
+    return lsize;
+}
+
+/*************************************************************************
+// The header passed to compressWithFilters() is the same for every block
+// of a multi-block pack, so compress and verify it once per method.
+**************************************************************************/
+
+unsigned Packer::compressHeader(const byte *hdr_ptr, unsigned hdr_len, int method,
+                                const byte **hdr_c_ptr) {
+    assert(hdr_ptr != nullptr && hdr_len > 0);
+    HeaderCacheEntry *e = nullptr;
+    for (unsigned i = 0; i < hdr_cache_n; i++) {
+        HeaderCacheEntry &x = hdr_cache[i];
+        if (x.method == method && x.u_len == hdr_len && memcmp(x.mb, hdr_ptr, hdr_len) == 0) {
+            e = &x;
+            break;
+        }
+    }
+    if (e == nullptr) {
+        if (hdr_cache_n == MAX_METHODS) // start over; not expected within one pack
+            hdr_cache_n = 0;
+        e = &hdr_cache[hdr_cache_n++];
+        e->method = method;
+        e->u_len = hdr_len;
+        e->c_len = 0;
+        e->mb.dealloc();
+        e->mb.allocForCompression(hdr_len, hdr_len);
+        memcpy(e->mb, hdr_ptr, hdr_len);
+        byte *const c_ptr = e->mb + hdr_len;
+        unsigned c_len = 0;
+        int r = upx_compress(hdr_ptr, hdr_len, c_ptr, &c_len, nullptr, method, 10, nullptr,
+                             nullptr);
+        if (r != UPX_E_OK)
+            throwInternalError("header compression failed");
+        if (c_len >= hdr_len)
+            throwInternalError("header compression size increase");
+        MemBuffer mb_uncLoader(10 + hdr_len);
+        unsigned unc_len = hdr_len;
+        r = upx_decompress(c_ptr, c_len, (unsigned char *) mb_uncLoader, &unc_len, method,
+                           nullptr);
+        if (r != UPX_E_OK)
+            throwInternalError("header compression failed");
+        e->c_len = c_len;
+    }
+    if (hdr_c_ptr != nullptr)
+        *hdr_c_ptr = e->mb + hdr_len;
+    return e->c_len;
+}
+
 /*************************************************************************
 //
 **************************************************************************/
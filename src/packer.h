@@ -34,6 +34,7 @@ class InputFile;
 class OutputFile;
 class UiPacker;
 class Filter;
+struct PackEstimate;
 
 /*************************************************************************
 // PackerBase: abstract minimal base class for all packers
@@ -75,6 +76,7 @@ public:
     virtual void doTest() = 0;
     virtual void doList() = 0;
     virtual void doFileInfo() = 0;
+    virtual void doEstimate() = 0;
 
     // arbitrary limits, increase as needed
     static constexpr unsigned MAX_METHODS = 8;  // for getCompressionMethods()
@@ -119,6 +121,7 @@ public:
     virtual void doTest() final override;
     virtual void doList() final override;
     virtual void doFileInfo() final override;
+    virtual void doEstimate() final override;
 
     // unpacker capabilities
     virtual bool canUnpackVersion(int version) const { return (version >= 8); }
@@ -136,11 +139,24 @@ protected:
     virtual void test();
     virtual void list();
     virtual void fileInfo();
+    virtual void estimate(PackEstimate *e); // see packer_e.cpp
+
+    // --estimate: the parts of the input file that pack() compresses;
+    //   returns the number of extents, or 0 if there are more than max
+    struct FileExtent {
+        upx_off_t offset;
+        upx_off_t size;
+    };
+    virtual unsigned getCompressedExtents(FileExtent *x, unsigned max) const;
 
 protected:
     // main compression drivers
+    struct CompressTrial; // upx_compress() done ahead, see compressWithFilters()
     bool compress(SPAN_P(byte) i_ptr, unsigned i_len, SPAN_P(byte) o_ptr,
-                  const upx_compress_config_t *cconf = nullptr);
+                  const upx_compress_config_t *cconf = nullptr,
+                  const CompressTrial *trial = nullptr);
+    void getCompressConfig(upx_compress_config_t *cconf, const upx_compress_config_t *cconf_parm,
+                           int method) const;
     void decompress(SPAN_P(const byte) in, SPAN_P(byte) out, bool verify_checksum = true,
                     Filter *ft = nullptr);
     virtual bool checkDefaultCompressionRatio(unsigned u_len, unsigned c_len) const;
@@ -165,6 +181,21 @@ protected:
                              unsigned overlap_range, const upx_compress_config_t *cconf,
                              int filter_strategy, bool inhibit_compression_check = false);
 
+    // compress hdr_ptr[] with method at level 10, verify, and return
+    // the compressed length; results are cached per method for the whole pack
+    unsigned compressHeader(const byte *hdr_ptr, unsigned hdr_len, int method,
+                            const byte **hdr_c_ptr = nullptr);
+
+    // buildLoader() and return getLoaderSize(), memoized per pack by
+    // (method, filter) when canMemoLoaderSize()
+    unsigned getTrialLoaderSize(const Filter *ft);
+    // true if the loader size does not depend on ph.u_len, ph.c_len, etc.
+    virtual bool canMemoLoaderSize() const { return false; }
+    // true if unpack() honors --extract-range
+    virtual bool canUnpackRange() const { return false; }
+    // true if pack() honors --preserve-symbols
+    virtual bool canPreserveSymbols() const { return false; }
+
     // util for verifying overlapping decompression
     //   non-destructive test
     virtual bool testOverlappingDecompression(const byte *buf, const byte *tbuf,
@@ -182,6 +213,9 @@ protected:
     virtual bool readPackHeader(int len, bool allow_incompressible = false) final;
     virtual void checkAlreadyPacked(const void *b, int blen) final;
 
+    // --time-budget: true once the deadline set by doPack() has passed
+    bool isTimeBudgetExpired() const;
+
     // loader core
     virtual void buildLoader(const Filter *ft) = 0;
     virtual Linker *newLinker() const = 0;
@@ -220,6 +254,7 @@ protected:
     const int *getDefaultCompressionMethods_8(int method, int level, int small = -1) const;
     const int *getDefaultCompressionMethods_le32(int method, int level, int small = -1) const;
     int prepareMethods(int *methods, int ph_method, const int *all_methods) const;
+    unsigned getDecompressionPenalty(int method, unsigned u_len) const;
     virtual const char *getDecompressorSections() const;
     virtual unsigned getDecompressorWrkmemSize() const;
     virtual void defineDecompressorSymbols();
@@ -338,6 +373,31 @@ protected:
     OwningPointer(Linker) linker = nullptr; // owner
 
 private:
+    // private to isTimeBudgetExpired() and compressWithFilters()
+    upx_uint64_t time_budget_deadline = 0; // steady clock in ms; 0 == unlimited
+    unsigned time_budget_tried = 0;
+    unsigned time_budget_skipped = 0;
+
+    // private to compressHeader()
+    struct HeaderCacheEntry {
+        int method = 0;
+        unsigned u_len = 0;
+        unsigned c_len = 0;
+        MemBuffer mb; // u_len bytes of header, then c_len bytes compressed
+    };
+    HeaderCacheEntry hdr_cache[MAX_METHODS];
+    unsigned hdr_cache_n = 0;
+
+    // private to getTrialLoaderSize()
+    struct LoaderSizeMemo {
+        int method;
+        int filter;
+        unsigned n_mru;
+        unsigned lsize;
+    };
+    LoaderSizeMemo lsize_memo[MAX_METHODS * MAX_FILTERS];
+    unsigned lsize_memo_n = 0;
+
     // private to checkPatch()
     void *last_patch = nullptr;
     int last_patch_len = 0;
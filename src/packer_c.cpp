@@ -93,6 +93,38 @@ const int *Packer::getDefaultCompressionMethods_le32(int method, int level, int
     return m_nrv2e;
 }
 
+// --optimize-for: the estimated decompression time of u_len bytes,
+// expressed in bytes of packed size that we are willing to give up for it.
+// Built-in table of relative decoding cost per byte. This is an estimate,
+// not a measurement: it encodes the common rule of thumb that LZMA
+// decodes roughly 7x slower than NRV, and NRV2D/NRV2E a little slower
+// than NRV2B. Replace it with stub timings once they are available.
+// Methods without an entry get the worst cost, so that they never win
+// by accident.
+unsigned Packer::getDecompressionPenalty(int method, unsigned u_len) const {
+    unsigned cost = 96; // in 1/8 of NRV2B
+    if (method == M_NONE)
+        cost = 0; // stored: a plain copy
+    else if (M_IS_NRV2B(method))
+        cost = 8;
+    else if (M_IS_NRV2D(method) || M_IS_NRV2E(method))
+        cost = 9;
+    else if (M_IS_ZSTD(method))
+        cost = 12;
+    else if (M_IS_DEFLATE(method))
+        cost = 24;
+    else if (M_IS_LZMA(method))
+        cost = 56;
+    else if (M_IS_BZIP2(method))
+        cost = 96;
+    unsigned weight = 0;
+    if (opt->optimize_for == opt->OPTIMIZE_BALANCED)
+        weight = 1;
+    else if (opt->optimize_for == opt->OPTIMIZE_STARTUP)
+        weight = 8;
+    return (unsigned) (((upx_uint64_t) u_len * cost * weight) >> 10);
+}
+
 /*************************************************************************
 // loader util
 **************************************************************************/
@@ -0,0 +1,267 @@
+/* packer_e.cpp -- Packer --estimate
+
+   This file is part of the UPX executable compressor.
+
+   Copyright (C) Markus Franz Xaver Johannes Oberhumer
+   Copyright (C) Laszlo Molnar
+   All Rights Reserved.
+
+   UPX and the UCL library are free software; you can redistribute them
+   and/or modify them under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.
+   If not, write to the Free Software Foundation, Inc.,
+   59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+   Markus F.X.J. Oberhumer              Laszlo Molnar
+   <markus@oberhumer.com>               <ezerotven+github@gmail.com>
+ */
+
+#include "util/system_headers.h"
+#include <chrono>
+#include "conf.h"
+#include "file.h"
+#include "packer.h"
+#include "ui.h"
+#include "util/membuffer.h"
+#include "util/work_sched.h"
+
+/*************************************************************************
+// --estimate
+//
+// The compressible extents of the file are cut into ESTIMATE_SAMPLES
+// strata of equal size, and ESTIMATE_SAMPLE_LEN bytes from the middle
+// of each stratum are compressed with every method that pack() would
+// try (systematic sampling). Small files are compressed completely.
+//
+// Packed size, pack time and decompression time are extrapolated from
+// the per-byte ratios of the samples; the variance is estimated from
+// the differences of neighbouring samples, which also catches the
+// usual trend from code to data within an executable.
+//
+// Known bias: samples are compressed independently and without
+// filters, so the predicted size errs on the high side for large
+// blocks; the size of the loader is not included. Decompression is
+// timed with the host library decoders instead of the stub.
+**************************************************************************/
+
+static constexpr unsigned ESTIMATE_SAMPLES = 16;
+static constexpr unsigned ESTIMATE_SAMPLE_LEN = 64 * 1024;
+
+namespace {
+struct EstimateSample final {
+    MemBuffer ibuf;
+    unsigned u_len = 0;
+    unsigned c_len[Packer::MAX_METHODS] = {};
+    double c_secs[Packer::MAX_METHODS] = {};
+    double d_secs[Packer::MAX_METHODS] = {};
+};
+
+// the variance of the mean of n systematic samples x[]
+//   (successive difference estimator, with finite population correction)
+static double sample_mean_var(const double *x, unsigned n, double fpc) {
+    if (n < 2)
+        return 0;
+    double sum = 0;
+    for (unsigned i = 1; i < n; i++)
+        sum += (x[i] - x[i - 1]) * (x[i] - x[i - 1]);
+    return fpc * sum / (2.0 * (n - 1)) / n;
+}
+
+static double sample_mean(const double *x, unsigned n) {
+    double sum = 0;
+    for (unsigned i = 0; i < n; i++)
+        sum += x[i];
+    return n ? sum / n : 0;
+}
+
+// number of filters that compressWithFilters() will run
+static unsigned count_filter_passes(const int *all_filters) {
+    if (!opt->all_filters || all_filters == nullptr)
+        return 1;
+    unsigned n = 1; // the "no filter" fallback
+    for (; *all_filters != FT_END; all_filters++) {
+        if (*all_filters == FT_ULTRA_BRUTE && !opt->ultra_brute)
+            break;
+        if (*all_filters != FT_SKIP && *all_filters != FT_ULTRA_BRUTE && *all_filters != 0)
+            n++;
+    }
+    return n;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+} // namespace
+
+unsigned Packer::getCompressedExtents(FileExtent *x, unsigned max) const {
+    if (max < 1)
+        return 0;
+    x[0].offset = 0;
+    x[0].size = file_size;
+    return 1;
+}
+
+void Packer::estimate(PackEstimate *e) {
+    // the compressible extents, clipped to the file
+    FileExtent extents[64];
+    unsigned nextents = getCompressedExtents(extents, 64);
+    if (nextents == 0)
+        nextents = Packer::getCompressedExtents(extents, 64);
+    upx_off_t total_len = 0;
+    for (unsigned i = 0; i < nextents; i++) {
+        FileExtent &x = extents[i];
+        if (x.offset < 0 || x.offset > file_size)
+            x.offset = file_size;
+        x.size = x.size < 0 ? 0 : upx::min(x.size, (upx_off_t) file_size - x.offset);
+        total_len += x.size;
+    }
+
+    // sample positions within the concatenated extents
+    unsigned nsamples;
+    upx_off_t stride, sample_pos0;
+    if (total_len <= (upx_off_t) ESTIMATE_SAMPLES * ESTIMATE_SAMPLE_LEN) {
+        nsamples = (unsigned) ((total_len + ESTIMATE_SAMPLE_LEN - 1) / ESTIMATE_SAMPLE_LEN);
+        stride = ESTIMATE_SAMPLE_LEN;
+        sample_pos0 = 0;
+        e->exact = true;
+    } else {
+        nsamples = ESTIMATE_SAMPLES;
+        stride = total_len / ESTIMATE_SAMPLES;
+        sample_pos0 = (stride - ESTIMATE_SAMPLE_LEN) / 2;
+    }
+
+    // read the samples; gathered across extent boundaries
+    EstimateSample samples[ESTIMATE_SAMPLES];
+    upx_uint64_t sampled_len = 0;
+    for (unsigned s = 0; s < nsamples; s++) {
+        EstimateSample &sample = samples[s];
+        upx_off_t pos = sample_pos0 + s * stride;
+        unsigned len = (unsigned) upx::min(total_len - pos, (upx_off_t) ESTIMATE_SAMPLE_LEN);
+        sample.ibuf.alloc(len);
+        unsigned i = 0;
+        while (pos >= extents[i].size) // find the extent of pos
+            pos -= extents[i++].size;
+        while (sample.u_len < len) {
+            const unsigned l =
+                (unsigned) upx::min(extents[i].size - pos, (upx_off_t) (len - sample.u_len));
+            fi->seek(extents[i].offset + pos, SEEK_SET);
+            fi->readx(sample.ibuf + sample.u_len, l);
+            sample.u_len += l;
+            i++;
+            pos = 0;
+        }
+        sampled_len += sample.u_len;
+    }
+    e->sampled_len = sampled_len;
+
+    // compress and decompress all samples with all methods
+    int methods[MAX_METHODS];
+    const int nmethods = prepareMethods(methods, ph.method, getCompressionMethods(M_ALL, ph.level));
+    assert_noexcept(nmethods > 0);
+    assert_noexcept(nmethods < (int) MAX_METHODS);
+    const int level = ph.level;
+    {
+        WorkGroup group;
+        for (unsigned s = 0; s < nsamples; s++)
+            for (int mm = 0; mm < nmethods; mm++) {
+                EstimateSample &sample = samples[s];
+                const int method = ph_forced_method(methods[mm]);
+                upx_compress_config_t cconf;
+                getCompressConfig(&cconf, nullptr, method);
+                group.run([&sample, mm, method, level, cconf]() {
+                    MemBuffer obuf, dbuf(sample.u_len);
+                    obuf.allocForCompression(sample.u_len);
+                    upx_compress_result_t cresult;
+                    unsigned c_len = 0;
+                    auto t0 = std::chrono::steady_clock::now();
+                    int r = upx_compress(sample.ibuf, sample.u_len, obuf, &c_len, nullptr, method,
+                                         level, &cconf, &cresult);
+                    sample.c_secs[mm] = seconds_since(t0);
+                    if (r == UPX_E_OUT_OF_MEMORY)
+                        throwOutOfMemoryException();
+                    if (r != UPX_E_OK)
+                        throwInternalError("compression failed");
+                    if (c_len >= sample.u_len) { // would be stored
+                        sample.c_len[mm] = sample.u_len;
+                        return;
+                    }
+                    sample.c_len[mm] = c_len;
+                    unsigned d_len = sample.u_len;
+                    t0 = std::chrono::steady_clock::now();
+                    r = upx_decompress(obuf, c_len, dbuf, &d_len, method, &cresult);
+                    sample.d_secs[mm] = seconds_since(t0);
+                    if (r != UPX_E_OK || d_len != sample.u_len)
+                        throwInternalError("decompression failed");
+                });
+            }
+        group.wait();
+    }
+
+    // the best method, judged like compressWithFilters() does
+    int best_mm = 0;
+    upx_uint64_t best_score = 0;
+    for (int mm = 0; mm < nmethods; mm++) {
+        upx_uint64_t score = 0;
+        for (unsigned s = 0; s < nsamples; s++)
+            score += samples[s].c_len[mm];
+        score += getDecompressionPenalty(methods[mm], (unsigned) sampled_len);
+        if (mm == 0 || score < best_score) {
+            best_mm = mm;
+            best_score = score;
+        }
+    }
+    e->method = ph_forced_method(methods[best_mm]);
+    e->level = level;
+
+    // extrapolate from the per-byte values of the samples
+    const double u = (double) total_len;
+    const unsigned passes = count_filter_passes(getFilters());
+    const double fpc = e->exact ? 0.0 : 1.0 - (double) sampled_len / u;
+    double ratio[ESTIMATE_SAMPLES], pack[ESTIMATE_SAMPLES], unpack[ESTIMATE_SAMPLES];
+    for (unsigned s = 0; s < nsamples; s++) {
+        const EstimateSample &sample = samples[s];
+        const double su = sample.u_len;
+        double secs = 0;
+        for (int mm = 0; mm < nmethods; mm++)
+            secs += sample.c_secs[mm] + sample.d_secs[mm]; // including the verify
+        ratio[s] = sample.c_len[best_mm] / su;
+        pack[s] = passes * secs / su;
+        unpack[s] = sample.d_secs[best_mm] / su;
+    }
+    e->c_len = (double) (file_size - total_len) + u * sample_mean(ratio, nsamples);
+    e->c_var = u * u * sample_mean_var(ratio, nsamples, fpc);
+    // timings are noisy even when all bytes were sampled, so no correction
+    e->pack_secs = u * sample_mean(pack, nsamples);
+    e->pack_var = u * u * sample_mean_var(pack, nsamples, 1.0);
+    e->unpack_secs = u * sample_mean(unpack, nsamples);
+    e->unpack_var = u * u * sample_mean_var(unpack, nsamples, 1.0);
+
+    if (opt->verbose >= 3)
+        info("Estimate: %u extent%s, %llu of %llu bytes sampled, %d method%s x %u filter pass%s",
+             nextents, nextents == 1 ? "" : "s", (unsigned long long) sampled_len,
+             (unsigned long long) total_len, nmethods, nmethods == 1 ? "" : "s",
+             passes, passes == 1 ? "" : "es");
+}
+
+/*************************************************************************
+//
+**************************************************************************/
+
+TEST_CASE("sample_mean_var") {
+    const double x[4] = {1, 3, 1, 3};
+    CHECK(sample_mean(x, 4) == 2);
+    CHECK(sample_mean_var(x, 1, 1.0) == 0);
+    CHECK(sample_mean_var(x, 4, 1.0) == 12.0 / 6 / 4);
+    CHECK(sample_mean_var(x, 4, 0.0) == 0);
+}
+
+/* vim:set ts=4 sw=4 et: */
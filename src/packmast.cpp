@@ -293,4 +293,10 @@ void PackMaster::fileInfo() may_throw {
     packer->doFileInfo();
 }
 
+void PackMaster::estimate() may_throw {
+    assert(packer == nullptr);
+    packer = getPacker(fi);
+    packer->doEstimate();
+}
+
 /* vim:set ts=4 sw=4 et: */
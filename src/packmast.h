@@ -45,6 +45,7 @@ public:
     void test() may_throw;
     void list() may_throw;
     void fileInfo() may_throw;
+    void estimate() may_throw;
 
     typedef tribool (*visit_func_t)(PackerBase *pb, void *user);
     static noinline PackerBase *visitAllPackers(visit_func_t, InputFile *f, const Options *,
@@ -28,6 +28,8 @@
 // INFO: not thread-safe; instantiated and used by class Packer, and the
 // static (global) variables are also updated in work.cpp
 
+#include "util/system_headers.h"
+#include <cmath> // std::sqrt
 #include "conf.h"
 #include "file.h"
 #include "packer.h"
@@ -589,6 +591,67 @@ void UiPacker::uiFileInfoEnd() { uiUpdate(); }
 
 /*static*/ void UiPacker::uiFileInfoTotal() {}
 
+/*************************************************************************
+// estimate
+**************************************************************************/
+
+// totals; the estimates of different files are independent, so the
+// variances simply add up
+static double total_est_c_var = 0;
+static double total_est_pack_secs = 0;
+static double total_est_pack_var = 0;
+static double total_est_unpack_secs = 0;
+static double total_est_unpack_var = 0;
+// files of a directory walk which are not executables, or too small
+static unsigned total_est_skipped = 0;
+
+// half width of the 95% confidence interval
+static double ci95(double var) { return 1.96 * std::sqrt(var > 0 ? var : 0); }
+
+static void print_estimate_line(double c_var, double pack_secs, double pack_var,
+                                double unpack_secs, double unpack_var, const char *comment) {
+    con_fprintf(stdout, "%12s+-%9.0f  (95%%)  pack %.2fs +-%.2f  unpack %.3fs +-%.3f  %s\n", "",
+                ci95(c_var), pack_secs, ci95(pack_var), unpack_secs, ci95(unpack_var), comment);
+}
+
+void UiPacker::uiEstimateStart() { total_files++; }
+
+void UiPacker::uiEstimateEnd(const PackEstimate &e) {
+    const upx_off_t c_len = (upx_off_t) (e.c_len + 0.5);
+    uiUpdate(c_len, pb->file_size);
+    total_est_c_var += e.c_var;
+    total_est_pack_secs += e.pack_secs;
+    total_est_pack_var += e.pack_var;
+    total_est_unpack_secs += e.unpack_secs;
+    total_est_unpack_var += e.unpack_var;
+
+    if (s->mode == M_QUIET)
+        return;
+    con_fprintf(stdout, "%s\n",
+                mkline(pb->file_size, c_len, 0, 0, pb->getName(), pb->fi->getName()));
+    char method_name[32 + 1];
+    set_method_name(method_name, sizeof(method_name), e.method, e.level);
+    char comment[64];
+    upx_safe_snprintf(comment, sizeof(comment), "%s%s", method_name, e.exact ? ", exact" : "");
+    print_estimate_line(e.c_var, e.pack_secs, e.pack_var, e.unpack_secs, e.unpack_var, comment);
+    printSetNl(0);
+}
+
+/*static*/ void UiPacker::uiEstimateTotal() {
+    if (opt->verbose >= 1 && total_files >= 2) {
+        uiListTotal();
+        print_estimate_line(total_est_c_var, total_est_pack_secs, total_est_pack_var,
+                            total_est_unpack_secs, total_est_unpack_var, "");
+        printSetNl(0);
+    }
+    uiFooter("Estimated");
+    if (opt->verbose >= 1 && total_est_skipped != 0)
+        con_fprintf(stdout, "Skipped %u file%s: not an executable, or too small.\n",
+                    total_est_skipped, total_est_skipped == 1 ? "" : "s");
+}
+
+/*static*/ void UiPacker::uiEstimateSkipped() { total_est_skipped++; }
+
 /*************************************************************************
 // util
 **************************************************************************/
@@ -30,6 +30,17 @@
 class OutputFile;
 class PackerBase;
 
+// --estimate: the prediction for one file; see packer_e.cpp
+struct PackEstimate final {
+    upx_uint64_t sampled_len = 0;  // bytes that actually were compressed
+    bool exact = false;            // all compressible bytes were sampled
+    double c_len = 0, c_var = 0;   // packed file size without loader, and its variance
+    double pack_secs = 0, pack_var = 0;
+    double unpack_secs = 0, unpack_var = 0;
+    int method = 0; // best method for the samples
+    int level = 0;
+};
+
 /*************************************************************************
 //
 **************************************************************************/
@@ -47,6 +58,8 @@ public:
     static void uiListTotal(bool uncompress = false);
     static void uiTestTotal();
     static void uiFileInfoTotal();
+    static void uiEstimateTotal();
+    static void uiEstimateSkipped();
 
     virtual void uiPackStart(const OutputFile *fo);
     virtual void uiPackEnd(const OutputFile *fo);
@@ -59,6 +72,8 @@ public:
     virtual void uiTestEnd();
     virtual bool uiFileInfoStart();
     virtual void uiFileInfoEnd();
+    virtual void uiEstimateStart();
+    virtual void uiEstimateEnd(const PackEstimate &e);
 
     // callback
     virtual void startCallback(unsigned u_len, unsigned step, int pass, int total_passes);
@@ -112,7 +112,7 @@ static_assert(sizeof(void *) == sizeof(long));
 // C++ system headers
 #include <algorithm>
 #include <memory> // std::unique_ptr
-// C++ multithreading (UPX currently does not use multithreading)
+// C++ multithreading; see util/work_sched.h
 #if __STDC_NO_ATOMICS__
 #undef WITH_THREADS
 #endif
@@ -568,6 +568,111 @@ TEST_CASE("upx_std_stable_sort") {
 #endif // C++20
 #endif // DEBUG
 
+/*************************************************************************
+// bulk bswap util
+**************************************************************************/
+
+#if (ACC_TARGET_FEATURE_AVX2)
+#include <immintrin.h>
+#elif (ACC_TARGET_FEATURE_SSSE3)
+#include <tmmintrin.h>
+#endif
+#if (ACC_TARGET_FEATURE_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+template <size_t N>
+struct BswapArray final {
+    static_assert(N == 2 || N == 4 || N == 8);
+    static forceinline void swap1(byte *p) noexcept {
+        if constexpr (N == 2)
+            set_ne16(p, bswap16(get_ne16(p)));
+        else if constexpr (N == 4)
+            set_ne32(p, bswap32(get_ne32(p)));
+        else
+            set_ne64(p, bswap64(get_ne64(p)));
+    }
+#if (ACC_TARGET_FEATURE_SSSE3)
+    // byte shuffle control for one 16-byte lane
+    static forceinline __m128i mask128() noexcept {
+        if constexpr (N == 2)
+            return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+        else if constexpr (N == 4)
+            return _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        else
+            return _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    }
+#endif
+    static void run(byte *p, size_t n) noexcept {
+        size_t bytes = n * N;
+#if (ACC_TARGET_FEATURE_AVX2)
+        if (bytes >= 32) {
+            // _mm256_shuffle_epi8 works per 128-bit lane, so just duplicate the mask
+            const __m256i m = _mm256_broadcastsi128_si256(mask128());
+            for (; bytes >= 32; bytes -= 32, p += 32) {
+                __m256i v = _mm256_loadu_si256((const __m256i *) (void *) p);
+                _mm256_storeu_si256((__m256i *) (void *) p, _mm256_shuffle_epi8(v, m));
+            }
+        }
+#endif
+#if (ACC_TARGET_FEATURE_SSSE3)
+        if (bytes >= 16) {
+            const __m128i m = mask128();
+            for (; bytes >= 16; bytes -= 16, p += 16) {
+                __m128i v = _mm_loadu_si128((const __m128i *) (void *) p);
+                _mm_storeu_si128((__m128i *) (void *) p, _mm_shuffle_epi8(v, m));
+            }
+        }
+#elif (ACC_TARGET_FEATURE_NEON)
+        for (; bytes >= 16; bytes -= 16, p += 16) {
+            uint8x16_t v = vld1q_u8(p);
+            if constexpr (N == 2)
+                v = vrev16q_u8(v);
+            else if constexpr (N == 4)
+                v = vrev32q_u8(v);
+            else
+                v = vrev64q_u8(v);
+            vst1q_u8(p, v);
+        }
+#endif
+        for (; bytes >= N; bytes -= N, p += N)
+            swap1(p);
+    }
+};
+} // namespace
+
+void bswap16_array(void *array, size_t n) noexcept { BswapArray<2>::run((byte *) array, n); }
+void bswap32_array(void *array, size_t n) noexcept { BswapArray<4>::run((byte *) array, n); }
+void bswap64_array(void *array, size_t n) noexcept { BswapArray<8>::run((byte *) array, n); }
+
+TEST_CASE("bswap_array") {
+    // compare against the scalar versions for all small sizes and alignments
+    upx_alignas_max byte a[8 + 8 * 40];
+    upx_alignas_max byte b[8 + 8 * 40];
+    for (unsigned i = 0; i < sizeof(a); i++)
+        a[i] = (byte) (i * 37 + 11);
+    for (size_t off = 0; off < 8; off++) {
+        for (size_t n = 0; n <= 40; n++) {
+            memcpy(b, a, sizeof(b));
+            bswap16_array(b + off, n);
+            for (size_t i = 0; i < n; i++)
+                CHECK(get_le16(b + off + 2 * i) == get_be16(a + off + 2 * i));
+            CHECK(memcmp(b + off + 2 * n, a + off + 2 * n, sizeof(a) - off - 2 * n) == 0);
+            memcpy(b, a, sizeof(b));
+            bswap32_array(b + off, n);
+            for (size_t i = 0; i < n; i++)
+                CHECK(get_le32(b + off + 4 * i) == get_be32(a + off + 4 * i));
+            CHECK(memcmp(b + off + 4 * n, a + off + 4 * n, sizeof(a) - off - 4 * n) == 0);
+            memcpy(b, a, sizeof(b));
+            bswap64_array(b + off, n);
+            for (size_t i = 0; i < n; i++)
+                CHECK(get_le64(b + off + 8 * i) == get_be64(a + off + 8 * i));
+            CHECK(memcmp(b, a, off) == 0);
+        }
+    }
+}
+
 /*************************************************************************
 // qsort() util
 **************************************************************************/
@@ -774,6 +879,125 @@ TEST_CASE("mem_replace") {
     UNUSED(b);
 }
 
+/*************************************************************************
+// cdc_cut - content-defined chunking with a "gear" rolling hash
+// (as in FastCDC); a cut depends only on the 64 bytes before it,
+// so chunk boundaries re-synchronize after an insertion or deletion
+**************************************************************************/
+
+namespace {
+struct GearTable final {
+    upx_uint64_t v[256];
+    GearTable() noexcept {
+        // splitmix64; the values must never change, else all chunks move
+        upx_uint64_t x = 0;
+        for (unsigned i = 0; i < 256; i++) {
+            x += 0x9e3779b97f4a7c15ULL;
+            upx_uint64_t z = x;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            v[i] = z ^ (z >> 31);
+        }
+    }
+};
+} // namespace
+
+unsigned cdc_cut(const void *buf, unsigned blen, unsigned min_len, unsigned avg_len) noexcept {
+    static const GearTable gear;
+    const byte *const b = (const byte *) buf;
+    if (blen <= min_len)
+        return blen;
+    // expected chunk length is (min_len + 2**bits)
+    unsigned bits = 0;
+    for (unsigned d = avg_len > min_len ? avg_len - min_len : 1; d > 1; d >>= 1)
+        bits++;
+    const upx_uint64_t mask = bits ? ~(upx_uint64_t) 0 << (64 - bits) : 0;
+    upx_uint64_t h = 0;
+    for (unsigned i = min_len; i < blen; i++) {
+        h = (h << 1) + gear.v[b[i]];
+        if (!(h & mask))
+            return i + 1;
+    }
+    return blen;
+}
+
+TEST_CASE("cdc_cut") {
+    constexpr unsigned N = 256 * 1024;
+    constexpr unsigned D = 37; // insertion
+    static byte mb[D + N];
+    upx_uint32_t x = 1;
+    for (unsigned i = 0; i < D + N; i++) {
+        x = x * 1103515245u + 12345u;
+        mb[i] = (byte) (x >> 24);
+    }
+    const byte *const a = mb + D; // original
+    const byte *const b = mb;     // with D bytes inserted at front
+    CHECK(cdc_cut(a, 100, 1024, 4096) == 100);
+    CHECK(cdc_cut(a, 2000, 1024, 1024) == 1025);
+    unsigned ia = 0, ib = 0, nchunks = 0, nsync = 0;
+    while (ia < N) {
+        unsigned l = cdc_cut(a + ia, UPX_MIN(N - ia, 16384u), 1024, 4096);
+        CHECK((l >= 1024 || ia + l == N));
+        CHECK(l <= 16384);
+        ia += l;
+        nchunks++;
+        while (ib < ia + D)
+            ib += cdc_cut(b + ib, UPX_MIN(D + N - ib, 16384u), 1024, 4096);
+        nsync += (ib == ia + D);
+    }
+    CHECK(nchunks > N / 8192);
+    CHECK(nchunks < N / 2048);
+    CHECK(nsync + 2 >= nchunks); // boundaries re-synchronize almost at once
+}
+
+/*************************************************************************
+// byte_entropy - a cheap compressibility estimate
+**************************************************************************/
+
+// log2(x) in 1/256 units, linear between powers of two; x > 0
+static unsigned log2_q8(unsigned x) noexcept {
+    unsigned n = 0;
+    while ((x >> n) > 1)
+        n++;
+    return (n << 8) + (unsigned) ((upx_uint64_t) (x - (1u << n)) * 256 >> n);
+}
+
+unsigned byte_entropy(const void *buf, unsigned blen) noexcept {
+    const byte *const b = (const byte *) buf;
+    if (blen == 0)
+        return 0;
+    unsigned count[256];
+    memset(count, 0, sizeof(count));
+    for (unsigned i = 0; i < blen; i++)
+        count[b[i]]++;
+    upx_uint64_t sum = 0; // of count * log2(count)
+    for (unsigned c : count)
+        if (c)
+            sum += (upx_uint64_t) c * log2_q8(c);
+    const unsigned e = (unsigned) (((upx_uint64_t) blen * log2_q8(blen) - sum) / blen);
+    return e < 2048 ? e : 2048; // log2_q8() is not exact
+}
+
+TEST_CASE("byte_entropy") {
+    static byte b[65536];
+    CHECK(byte_entropy(b, 0) == 0);
+    CHECK(byte_entropy(b, sizeof(b)) == 0);
+    for (unsigned i = 0; i < 512; i++)
+        b[i] = (byte) i;
+    CHECK(byte_entropy(b, 512) == 2048);
+    CHECK(byte_entropy(b, 16) == 1024);
+    upx_uint32_t x = 1;
+    for (unsigned i = 0; i < sizeof(b); i++) {
+        x = x * 1103515245u + 12345u;
+        b[i] = (byte) (x >> 24);
+    }
+    CHECK(byte_entropy(b, sizeof(b)) >= 7 * 256 + 224);
+    for (unsigned i = 0; i < sizeof(b); i++)
+        b[i] &= 0x0f;
+    CHECK(byte_entropy(b, sizeof(b)) >= 4 * 256 - 16);
+    CHECK(byte_entropy(b, sizeof(b)) <= 4 * 256 + 16);
+}
+
 /*************************************************************************
 // bele.h globals
 **************************************************************************/
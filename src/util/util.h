@@ -234,6 +234,11 @@ int find_le64(const void *b, int blen, upx_uint64_t what) noexcept;
 
 int mem_replace(void *b, int blen, const void *what, int wlen, const void *r) noexcept;
 
+// content-defined chunking: length of the first chunk of b[0..blen)
+unsigned cdc_cut(const void *b, unsigned blen, unsigned min_len, unsigned avg_len) noexcept;
+// order-0 entropy of b[0..blen) in 1/256 bits per byte (0 .. 2048)
+unsigned byte_entropy(const void *b, unsigned blen) noexcept;
+
 char *fn_basename(const char *name);
 int fn_strcmp(const char *n1, const char *n2);
 char *fn_strlwr(char *n);
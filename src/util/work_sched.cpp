@@ -0,0 +1,261 @@
+/* work_sched.cpp --
+
+   This file is part of the UPX executable compressor.
+
+   Copyright (C) Markus Franz Xaver Johannes Oberhumer
+   All Rights Reserved.
+
+   UPX and the UCL library are free software; you can redistribute them
+   and/or modify them under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.
+   If not, write to the Free Software Foundation, Inc.,
+   59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+   Markus F.X.J. Oberhumer
+   <markus@oberhumer.com>
+ */
+
+#include "../conf.h"
+#include "work_sched.h"
+#if WITH_THREADS
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <vector>
+#endif
+
+/*************************************************************************
+// Tasks are coarse (a whole compression run), so a single mutex guards
+// all queues; the per-thread queues still keep nested work local.
+**************************************************************************/
+
+#if WITH_THREADS
+
+// the pool and queue index of the current thread; 0 outside of a pool
+static upx_thread_local const void *work_sched_impl = nullptr;
+static upx_thread_local unsigned work_sched_index = 0;
+
+struct WorkScheduler::Impl {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::deque<Task *> > queues; // [0] is shared by all outside threads
+    std::vector<std::thread> threads;
+    bool stopping = false;
+
+    unsigned self() const noexcept { return work_sched_impl == this ? work_sched_index : 0; }
+
+    // the newest own task, else the oldest task of another queue; needs mutex
+    Task *pop(unsigned self) noexcept {
+        std::deque<Task *> &own = queues[self];
+        if (!own.empty()) {
+            Task *task = own.back();
+            own.pop_back();
+            return task;
+        }
+        const size_t n = queues.size();
+        for (size_t i = 1; i < n; i++) {
+            std::deque<Task *> &q = queues[(self + i) % n];
+            if (!q.empty()) {
+                Task *task = q.front();
+                q.pop_front();
+                return task;
+            }
+        }
+        return nullptr;
+    }
+};
+
+#endif // WITH_THREADS
+
+WorkScheduler::WorkScheduler(unsigned n) : concurrency(n < 1 ? 1 : n) {
+#if WITH_THREADS
+    if (concurrency < 2)
+        return;
+    impl = new Impl;
+    impl->queues.resize(concurrency);
+    for (unsigned i = 1; i < concurrency; i++) {
+        try {
+            impl->threads.emplace_back([this, i]() {
+                work_sched_impl = impl;
+                work_sched_index = i;
+                std::unique_lock<std::mutex> lock(impl->mutex);
+                for (;;) {
+                    Task *task = impl->pop(i);
+                    if (task != nullptr) {
+                        lock.unlock();
+                        runTask(task);
+                        lock.lock();
+                    } else if (impl->stopping)
+                        break;
+                    else
+                        impl->cv.wait(lock);
+                }
+            });
+        } catch (...) {
+            break; // make do with the threads we have got
+        }
+    }
+    concurrency = 1 + (unsigned) impl->threads.size();
+    if (concurrency < 2) {
+        delete impl;
+        impl = nullptr;
+    }
+#endif
+}
+
+WorkScheduler::~WorkScheduler() noexcept {
+#if WITH_THREADS
+    if (impl == nullptr)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(impl->mutex);
+        impl->stopping = true;
+    }
+    impl->cv.notify_all();
+    for (auto &t : impl->threads)
+        t.join();
+    delete impl;
+    impl = nullptr;
+#endif
+}
+
+WorkScheduler &WorkScheduler::get() {
+    static WorkScheduler sched([]() noexcept -> unsigned {
+        if (opt->threads)
+            return opt->threads;
+#if WITH_THREADS
+        return std::thread::hardware_concurrency(); // 0 if unknown
+#else
+        return 1;
+#endif
+    }());
+    return sched;
+}
+
+void WorkScheduler::submit(Task *task) {
+#if WITH_THREADS
+    if (impl != nullptr) {
+        {
+            std::lock_guard<std::mutex> lock(impl->mutex);
+            try {
+                impl->queues[impl->self()].push_back(task);
+            } catch (...) {
+                delete task;
+                throw;
+            }
+            task->group->pending += 1;
+        }
+        // wake everyone: a waiter whose own group is already done would
+        // not take the task
+        impl->cv.notify_all();
+        return;
+    }
+#endif
+    task->group->pending += 1;
+    runTask(task);
+}
+
+void WorkScheduler::runTask(Task *task) noexcept {
+    WorkGroup *const group = task->group;
+    std::exception_ptr e;
+    try {
+        task->execute();
+    } catch (...) {
+        e = std::current_exception();
+    }
+    delete task;
+#if WITH_THREADS
+    if (impl != nullptr) {
+        std::lock_guard<std::mutex> lock(impl->mutex);
+        if (e && !group->first_exception)
+            group->first_exception = e;
+        if (--group->pending == 0)
+            impl->cv.notify_all();
+        return; // NOTE: group may be gone once the mutex is released
+    }
+#endif
+    if (e && !group->first_exception)
+        group->first_exception = e;
+    group->pending -= 1;
+}
+
+void WorkScheduler::wait(WorkGroup *group) {
+#if WITH_THREADS
+    if (impl != nullptr) {
+        const unsigned self = impl->self();
+        std::unique_lock<std::mutex> lock(impl->mutex);
+        while (group->pending != 0) {
+            Task *task = impl->pop(self);
+            if (task != nullptr) {
+                lock.unlock();
+                runTask(task);
+                lock.lock();
+            } else
+                impl->cv.wait(lock);
+        }
+        return;
+    }
+#endif
+    assert_noexcept(group->pending == 0);
+}
+
+/*************************************************************************
+// WorkGroup
+**************************************************************************/
+
+WorkGroup::~WorkGroup() noexcept {
+    // tasks may refer to the caller's stack; never leave them running
+    try {
+        sched.wait(this);
+    } catch (...) {
+        // IGNORE_ERROR
+    }
+}
+
+void WorkGroup::wait() may_throw {
+    sched.wait(this);
+    std::exception_ptr e;
+    std::swap(e, first_exception); // no task is left to touch it
+    if (e)
+        std::rethrow_exception(e);
+}
+
+/*************************************************************************
+//
+**************************************************************************/
+
+TEST_CASE("WorkScheduler") {
+    for (unsigned n = 1; n <= 4; n += 3) {
+        WorkScheduler sched(n);
+        CHECK(sched.getConcurrency() >= 1);
+        upx_std_atomic(unsigned) sum{0};
+        WorkGroup outer(sched);
+        for (unsigned i = 1; i <= 100; i++)
+            outer.run([&sched, &sum, i]() {
+                WorkGroup inner(sched); // nested groups share the threads
+                for (unsigned j = 0; j < i; j++)
+                    inner.run([&sum]() { sum += 1; });
+                inner.wait();
+            });
+        outer.wait();
+        CHECK(unsigned(sum) == 5050);
+
+        WorkGroup g(sched);
+        g.run([]() { throwInternalError("WorkScheduler test"); });
+        g.run([&sum]() { sum += 1; });
+        CHECK_THROWS(g.wait());
+        CHECK(unsigned(sum) == 5051);
+        CHECK_NOTHROW(g.wait()); // reported once
+    }
+}
+
+/* vim:set ts=4 sw=4 et: */
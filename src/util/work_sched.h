@@ -0,0 +1,100 @@
+/* work_sched.h --
+
+   This file is part of the UPX executable compressor.
+
+   Copyright (C) Markus Franz Xaver Johannes Oberhumer
+   All Rights Reserved.
+
+   UPX and the UCL library are free software; you can redistribute them
+   and/or modify them under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of
+   the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; see the file COPYING.
+   If not, write to the Free Software Foundation, Inc.,
+   59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+   Markus F.X.J. Oberhumer
+   <markus@oberhumer.com>
+ */
+
+#pragma once
+
+/*************************************************************************
+// WorkScheduler - a small work-stealing thread pool
+//
+// All parallel work of the process goes through WorkScheduler::get(),
+// so the --threads limit holds for everything. Every thread has its own
+// task queue: the owner takes the newest task, idle threads steal the
+// oldest one from the others. WorkGroup::wait() runs queued tasks
+// instead of blocking, so groups can nest without adding threads.
+//
+// Without WITH_THREADS all tasks simply run inline.
+**************************************************************************/
+
+class WorkGroup;
+
+class WorkScheduler final : private upx::noncopyable {
+public:
+    // concurrency: total number of threads, including the caller of wait()
+    explicit WorkScheduler(unsigned concurrency);
+    ~WorkScheduler() noexcept;
+
+    // the process-wide scheduler; sized from opt->threads on first use
+    static WorkScheduler &get();
+
+    unsigned getConcurrency() const noexcept { return concurrency; }
+
+    struct Task {
+        WorkGroup *group = nullptr;
+        virtual ~Task() noexcept {}
+        virtual void execute() = 0;
+    };
+
+private:
+    friend class WorkGroup;
+    void submit(Task *task);
+    void wait(WorkGroup *group);
+    void runTask(Task *task) noexcept;
+
+    unsigned concurrency;
+    struct Impl;
+    Impl *impl = nullptr; // owner
+};
+
+class WorkGroup final : private upx::noncopyable {
+public:
+    explicit WorkGroup(WorkScheduler &s = WorkScheduler::get()) noexcept : sched(s) {}
+    ~WorkGroup() noexcept;
+
+    // queue f() for execution by any thread
+    template <class F>
+    void run(F &&f) {
+        struct TaskF final : public WorkScheduler::Task {
+            std::decay_t<F> func;
+            explicit TaskF(F &&ff) : func(std::forward<F>(ff)) {}
+            virtual void execute() override { func(); }
+        };
+        TaskF *task = new TaskF(std::forward<F>(f));
+        task->group = this;
+        sched.submit(task);
+    }
+
+    // run queued tasks until all tasks of this group are done;
+    // then rethrow the first exception thrown by any of them
+    void wait() may_throw;
+
+private:
+    friend class WorkScheduler;
+    WorkScheduler &sched;
+    unsigned pending = 0;               // guarded by WorkScheduler::Impl::mutex
+    std::exception_ptr first_exception; // ditto
+};
+
+/* vim:set ts=4 sw=4 et: */
@@ -40,6 +40,9 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #endif
+#if HAVE_DIRENT_H
+#include <dirent.h> // --estimate
+#endif
 #include "conf.h"
 #include "file.h"
 #include "packmast.h"
@@ -248,6 +251,8 @@ void do_one_file(const char *const iname, char *const oname) may_throw {
             skip = false;
         else if (opt->backup)
             skip = false;
+        else if (opt->estimate)
+            skip = false; // nothing gets written
         if (skip)
             throwIOException("file is write protected -- skipped");
     }
@@ -273,7 +278,7 @@ void do_one_file(const char *const iname, char *const oname) may_throw {
     OutputFile fo;
     bool preserve_link = opt->preserve_link;
     bool copy_timestamp_only = false;
-    if (opt->cmd == CMD_COMPRESS || opt->cmd == CMD_DECOMPRESS) {
+    if ((opt->cmd == CMD_COMPRESS || opt->cmd == CMD_DECOMPRESS) && !opt->estimate) {
         if (opt->to_stdout) {
             preserve_link = false; // not needed
             if (!fo.openStdout(1, opt->force ? true : false))
@@ -331,7 +336,9 @@ void do_one_file(const char *const iname, char *const oname) may_throw {
     // handle command - actual work starts HERE
     {
         PackMaster pm(&fi, opt);
-        if (opt->cmd == CMD_COMPRESS)
+        if (opt->cmd == CMD_COMPRESS && opt->estimate)
+            pm.estimate();
+        else if (opt->cmd == CMD_COMPRESS)
             pm.pack(&fo);
         else if (opt->cmd == CMD_DECOMPRESS)
             pm.unpack(&fo);
@@ -408,6 +415,110 @@ static void unlink_ofile(char *oname) noexcept {
     }
 }
 
+// returns -1 on a fatal error
+// --estimate: files found by do_directory() which are not executables
+//   are skipped quietly and only counted
+static int do_one_file_catch(const char *const iname, bool walked = false) {
+    infoHeader();
+
+    char oname[ACC_FN_PATH_MAX + 1];
+    oname[0] = 0;
+
+    try {
+        do_one_file(iname, oname);
+    } catch (const UnknownExecutableFormatException &e) {
+        unlink_ofile(oname);
+        if (walked)
+            UiPacker::uiEstimateSkipped();
+        else {
+            if (opt->verbose >= 1 || (opt->verbose >= 0 && !e.isWarning()))
+                printErr(iname, e);
+            main_set_exit_code(e.isWarning() ? EXIT_WARN : EXIT_ERROR);
+        }
+    } catch (const Exception &e) {
+        unlink_ofile(oname);
+        if (opt->verbose >= 1 || (opt->verbose >= 0 && !e.isWarning()))
+            printErr(iname, e);
+        main_set_exit_code(e.isWarning() ? EXIT_WARN : EXIT_ERROR);
+        // this is not fatal, continue processing more files
+    } catch (const Error &e) {
+        unlink_ofile(oname);
+        printErr(iname, e);
+        main_set_exit_code(EXIT_ERROR);
+        return -1; // fatal error
+    } catch (std::bad_alloc *e) {
+        unlink_ofile(oname);
+        printErr(iname, "out of memory");
+        UNUSED(e);
+        // delete e;
+        main_set_exit_code(EXIT_ERROR);
+        return -1; // fatal error
+    } catch (const std::bad_alloc &) {
+        unlink_ofile(oname);
+        printErr(iname, "out of memory");
+        main_set_exit_code(EXIT_ERROR);
+        return -1; // fatal error
+    } catch (std::exception *e) {
+        unlink_ofile(oname);
+        printUnhandledException(iname, e);
+        // delete e;
+        main_set_exit_code(EXIT_ERROR);
+        return -1; // fatal error
+    } catch (const std::exception &e) {
+        unlink_ofile(oname);
+        printUnhandledException(iname, &e);
+        main_set_exit_code(EXIT_ERROR);
+        return -1; // fatal error
+    } catch (...) {
+        unlink_ofile(oname);
+        printUnhandledException(iname, nullptr);
+        main_set_exit_code(EXIT_ERROR);
+        return -1; // fatal error
+    }
+    return 0;
+}
+
+#if HAVE_DIRENT_H
+// --estimate: process all regular files below a directory; symlinks are
+// not followed; returns -1 on a fatal error
+static int do_directory(const char *const dname) {
+    DIR *dir = opendir(dname);
+    if (dir == nullptr) {
+        printErr(dname, "cannot open directory: %s", strerror(errno));
+        main_set_exit_code(EXIT_ERROR);
+        return 0; // not fatal
+    }
+    int r = 0;
+    const struct dirent *de;
+    while (r >= 0 && (de = readdir(dir)) != nullptr) {
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+            continue;
+        char path[ACC_FN_PATH_MAX + 1];
+        if (strlen(dname) + 1 + strlen(de->d_name) >= sizeof(path)) {
+            printErr(dname, "path too long -- skipped: %s", de->d_name);
+            main_set_exit_code(EXIT_ERROR);
+            continue;
+        }
+        upx_safe_snprintf(path, sizeof(path), "%s/%s", dname, de->d_name);
+        struct stat st = {};
+#if HAVE_LSTAT
+        if (lstat(path, &st) != 0)
+#else
+        if (stat(path, &st) != 0)
+#endif
+            continue;
+        if (S_ISDIR(st.st_mode))
+            r = do_directory(path);
+        else if (S_ISREG(st.st_mode) && st.st_size < 512) // see do_one_file()
+            UiPacker::uiEstimateSkipped();
+        else if (S_ISREG(st.st_mode))
+            r = do_one_file_catch(path, true);
+    }
+    (void) closedir(dir);
+    return r;
+}
+#endif
+
 int do_files(int i, int argc, char *argv[]) may_throw {
     upx_compiler_sanity_check();
     if (opt->verbose >= 1) {
@@ -416,57 +527,22 @@ int do_files(int i, int argc, char *argv[]) may_throw {
     }
 
     for (; i < argc; i++) {
-        infoHeader();
-
         const char *const iname = argv[i];
-        char oname[ACC_FN_PATH_MAX + 1];
-        oname[0] = 0;
-
-        try {
-            do_one_file(iname, oname);
-        } catch (const Exception &e) {
-            unlink_ofile(oname);
-            if (opt->verbose >= 1 || (opt->verbose >= 0 && !e.isWarning()))
-                printErr(iname, e);
-            main_set_exit_code(e.isWarning() ? EXIT_WARN : EXIT_ERROR);
-            // this is not fatal, continue processing more files
-        } catch (const Error &e) {
-            unlink_ofile(oname);
-            printErr(iname, e);
-            main_set_exit_code(EXIT_ERROR);
-            return -1; // fatal error
-        } catch (std::bad_alloc *e) {
-            unlink_ofile(oname);
-            printErr(iname, "out of memory");
-            UNUSED(e);
-            // delete e;
-            main_set_exit_code(EXIT_ERROR);
-            return -1; // fatal error
-        } catch (const std::bad_alloc &) {
-            unlink_ofile(oname);
-            printErr(iname, "out of memory");
-            main_set_exit_code(EXIT_ERROR);
-            return -1; // fatal error
-        } catch (std::exception *e) {
-            unlink_ofile(oname);
-            printUnhandledException(iname, e);
-            // delete e;
-            main_set_exit_code(EXIT_ERROR);
-            return -1; // fatal error
-        } catch (const std::exception &e) {
-            unlink_ofile(oname);
-            printUnhandledException(iname, &e);
-            main_set_exit_code(EXIT_ERROR);
-            return -1; // fatal error
-        } catch (...) {
-            unlink_ofile(oname);
-            printUnhandledException(iname, nullptr);
-            main_set_exit_code(EXIT_ERROR);
-            return -1; // fatal error
+#if HAVE_DIRENT_H
+        struct stat st = {};
+        if (opt->estimate && stat(iname, &st) == 0 && S_ISDIR(st.st_mode)) {
+            if (do_directory(iname) < 0)
+                return -1; // fatal error
+            continue;
         }
+#endif
+        if (do_one_file_catch(iname) < 0)
+            return -1; // fatal error
     }
 
-    if (opt->cmd == CMD_COMPRESS)
+    if (opt->cmd == CMD_COMPRESS && opt->estimate)
+        UiPacker::uiEstimateTotal();
+    else if (opt->cmd == CMD_COMPRESS)
         UiPacker::uiPackTotal();
     else if (opt->cmd == CMD_DECOMPRESS)
         UiPacker::uiUnpackTotal();